@@ -0,0 +1,393 @@
+#ifndef _BALANCE_HEADER
+#define _BALANCE_HEADER
+
+#include "defs.hpp"
+#include <functional>
+#include <vector>
+
+/*
+    Balancing policies for `SearchTree`.
+    Every policy keeps its per-unit data in `unit::height` and provides:
+        initialize(node)               - Set up a freshly allocated unit.
+        grown_right(root, rotations)   - Repair `root` after an insertion into its right subtree,
+        grown_left(root, rotations)      add the rotations done to the `RotationCounter`, and
+                                         return the new root.
+        finish(root)                   - Fix up the root of the whole tree after an insertion.
+        build(nodes, amount, resource) - Link sorted units into a valid tree and return its root,
+                                         taking any scratch memory from `resource`.
+        height(root)                   - Height of a non-empty tree.
+*/
+
+/*
+    Rotations done by a policy, counted only for `Counted<Balance>` so that other trees neither
+    store the counter nor update it while inserting.
+*/
+template <bool enabled>
+struct RotationCounter
+{
+    size_t amount = 0;
+
+    RotationCounter &operator+=(size_t rotations)
+    {
+        amount += rotations;
+        return *this;
+    }
+
+    size_t value(void) const { return amount; }
+};
+
+template <>
+struct RotationCounter<false>
+{
+    RotationCounter &operator+=(size_t) { return *this; }
+
+    size_t value(void) const { return 0; }
+};
+
+struct BalanceBase
+{
+    static constexpr bool counts_rotations = false;
+
+    template <typename unit>
+    static unit *single_rotate_right(unit *root) // The right child becomes the root.
+    {
+        unit *tmp = root->right;
+        root->right = tmp->left;
+        tmp->left = root;
+        return tmp;
+    }
+
+    template <typename unit>
+    static unit *single_rotate_left(unit *root) // The left child becomes the root.
+    {
+        unit *tmp = root->left;
+        root->left = tmp->right;
+        tmp->right = root;
+        return tmp;
+    }
+
+    template <typename unit>
+    static unit *finish(unit *root) { return root; }
+
+    template <typename unit>
+    static size_t height(unit *root)
+    {
+        size_t left = (root->left) ? height(root->left) + 1 : 0;
+        size_t right = (root->right) ? height(root->right) + 1 : 0;
+        return (left > right) ? left : right;
+    }
+
+    /*
+        Split at the middle, the left half taking the extra unit.
+        Units missing a child then only appear on the last two levels, the deepest being floor(log2(amount)).
+    */
+    template <typename unit, typename label_t>
+    static unit *build_balanced(unit **nodes, size_t amount, size_t depth, label_t &&label)
+    {
+        if (amount == 0)
+            return nullptr;
+
+        size_t middle = amount / 2;
+        unit *root = nodes[middle];
+        root->left = build_balanced(nodes, middle, depth + 1, label);
+        root->right = build_balanced(nodes + middle + 1, amount - middle - 1, depth + 1, label);
+        label(root, depth);
+        return root;
+    }
+};
+
+struct AVL : BalanceBase // `height` is the height of the subtree.
+{
+    template <typename unit>
+    static decltype(unit::height) measure_height(unit *root) { return (root) ? root->height : -1; }
+
+    template <typename unit>
+    static void update_height(unit *root)
+    {
+        root->height = (measure_height(root->left) > measure_height(root->right)) ? measure_height(root->left) + 1 : measure_height(root->right) + 1;
+    }
+
+    template <typename unit>
+    static unit *single_rotate_right(unit *root)
+    {
+        unit *tmp = BalanceBase::single_rotate_right(root);
+        update_height(root);
+        update_height(tmp);
+        return tmp;
+    }
+
+    template <typename unit>
+    static unit *single_rotate_left(unit *root)
+    {
+        unit *tmp = BalanceBase::single_rotate_left(root);
+        update_height(root);
+        update_height(tmp);
+        return tmp;
+    }
+
+    template <typename unit>
+    static unit *double_rotate_right(unit *root)
+    {
+        root->right = single_rotate_left(root->right);
+        return single_rotate_right(root);
+    }
+
+    template <typename unit>
+    static unit *double_rotate_left(unit *root)
+    {
+        root->left = single_rotate_right(root->left);
+        return single_rotate_left(root);
+    }
+
+    template <typename unit>
+    static void initialize(unit *node) { node->height = 0; }
+
+    template <typename unit, typename counter_t>
+    static unit *grown_right(unit *root, counter_t &rotations)
+    {
+        if (measure_height(root->right) - measure_height(root->left) == 2)
+        {
+            if (measure_height(root->right->right) > measure_height(root->right->left))
+                root = single_rotate_right(root), rotations += 1;
+            else
+                root = double_rotate_right(root), rotations += 2;
+        }
+        update_height(root);
+        return root;
+    }
+
+    template <typename unit, typename counter_t>
+    static unit *grown_left(unit *root, counter_t &rotations)
+    {
+        if (measure_height(root->left) - measure_height(root->right) == 2)
+        {
+            if (measure_height(root->left->left) > measure_height(root->left->right))
+                root = single_rotate_left(root), rotations += 1;
+            else
+                root = double_rotate_left(root), rotations += 2;
+        }
+        update_height(root);
+        return root;
+    }
+
+    template <typename unit>
+    static unit *build(unit **nodes, size_t amount, memory_resource *)
+    {
+        return build_balanced(nodes, amount, 0, [](unit *root, size_t) { update_height(root); });
+    }
+
+    template <typename unit>
+    static size_t height(unit *root) { return static_cast<size_t>(root->height); }
+};
+
+/*
+    Weak AVL: `height` is the rank, and every rank difference is 1 or 2 (null has rank -1, leaves 0).
+    It rotates at most twice per insertion; since `SearchTree::remove` only clears counts and never
+    deletes units, it makes the same rotations as AVL here and differs only in bookkeeping.
+*/
+struct WAVL : BalanceBase
+{
+    template <typename unit>
+    static decltype(unit::height) rank(unit *root) { return (root) ? root->height : -1; }
+
+    template <typename unit>
+    static void initialize(unit *node) { node->height = 0; }
+
+    template <typename unit, typename counter_t>
+    static unit *grown_right(unit *root, counter_t &rotations)
+    {
+        unit *child = root->right;
+        if (rank(child) != rank(root))
+            return root;
+        if (rank(root) - rank(root->left) == 1) // The sibling is a 1-child: promote and go on.
+        {
+            root->height++;
+            return root;
+        }
+
+        unit *inner = child->left;
+        if (rank(child) - rank(inner) == 2)
+        {
+            root->height--;
+            rotations += 1;
+            return single_rotate_right(root);
+        }
+        inner->height++, child->height--, root->height--;
+        root->right = single_rotate_left(child);
+        rotations += 2;
+        return single_rotate_right(root);
+    }
+
+    template <typename unit, typename counter_t>
+    static unit *grown_left(unit *root, counter_t &rotations)
+    {
+        unit *child = root->left;
+        if (rank(child) != rank(root))
+            return root;
+        if (rank(root) - rank(root->right) == 1)
+        {
+            root->height++;
+            return root;
+        }
+
+        unit *inner = child->right;
+        if (rank(child) - rank(inner) == 2)
+        {
+            root->height--;
+            rotations += 1;
+            return single_rotate_left(root);
+        }
+        inner->height++, child->height--, root->height--;
+        root->left = single_rotate_right(child);
+        rotations += 2;
+        return single_rotate_left(root);
+    }
+
+    template <typename unit>
+    static unit *build(unit **nodes, size_t amount, memory_resource *resource) // An AVL tree is a WAVL tree with rank = height.
+    {
+        return AVL::build(nodes, amount, resource);
+    }
+};
+
+/*
+    Red-black tree with Okasaki's insertion: a black unit with a red child and a red grandchild
+    is restructured into a red unit with two black children. `height` is the colour.
+*/
+struct RedBlack : BalanceBase
+{
+    static constexpr char black = 0, red = 1;
+
+    template <typename unit>
+    static bool is_red(unit *root) { return root && root->height == red; }
+
+    template <typename unit>
+    static unit *recolour(unit *root) // Red root, black children.
+    {
+        root->height = red;
+        root->left->height = root->right->height = black;
+        return root;
+    }
+
+    template <typename unit>
+    static void initialize(unit *node) { node->height = red; }
+
+    template <typename unit, typename counter_t>
+    static unit *grown_right(unit *root, counter_t &rotations)
+    {
+        if (is_red(root) || !is_red(root->right))
+            return root;
+        if (is_red(root->right->right))
+        {
+            rotations += 1;
+            return recolour(single_rotate_right(root));
+        }
+        if (is_red(root->right->left))
+        {
+            root->right = single_rotate_left(root->right);
+            rotations += 2;
+            return recolour(single_rotate_right(root));
+        }
+        return root;
+    }
+
+    template <typename unit, typename counter_t>
+    static unit *grown_left(unit *root, counter_t &rotations)
+    {
+        if (is_red(root) || !is_red(root->left))
+            return root;
+        if (is_red(root->left->left))
+        {
+            rotations += 1;
+            return recolour(single_rotate_left(root));
+        }
+        if (is_red(root->left->right))
+        {
+            root->left = single_rotate_right(root->left);
+            rotations += 2;
+            return recolour(single_rotate_left(root));
+        }
+        return root;
+    }
+
+    template <typename unit>
+    static unit *finish(unit *root)
+    {
+        root->height = black;
+        return root;
+    }
+
+    template <typename unit>
+    static unit *build(unit **nodes, size_t amount, memory_resource *) // Only the deepest level is red.
+    {
+        size_t deepest = 0;
+        for (size_t rest = amount; rest > 1; rest /= 2)
+            deepest++;
+        unit *root = build_balanced(nodes, amount, 0, [deepest](unit *node, size_t depth)
+                                    { node->height = (depth == deepest && depth > 0) ? red : black; });
+        return root;
+    }
+};
+
+/*
+    Treap whose priorities are a hash of the element, so nothing extra is stored
+    and moving a unit in memory keeps the shape valid.
+*/
+struct Treap : BalanceBase
+{
+    template <typename unit>
+    static uint64_t priority(unit *root)
+    {
+        typedef decay_t<decltype(root->element)> element_t;
+        return mix_bits(static_cast<uint64_t>(std::hash<element_t>()(root->element)));
+    }
+
+    template <typename unit>
+    static void initialize(unit *node) { node->height = 0; }
+
+    template <typename unit, typename counter_t>
+    static unit *grown_right(unit *root, counter_t &rotations)
+    {
+        if (root->right && priority(root->right) > priority(root))
+            root = single_rotate_right(root), rotations += 1;
+        return root;
+    }
+
+    template <typename unit, typename counter_t>
+    static unit *grown_left(unit *root, counter_t &rotations)
+    {
+        if (root->left && priority(root->left) > priority(root))
+            root = single_rotate_left(root), rotations += 1;
+        return root;
+    }
+
+    template <typename unit>
+    static unit *build(unit **nodes, size_t amount, memory_resource *resource) // Cartesian tree in linear time.
+    {
+        if (amount == 0)
+            return nullptr;
+
+        std::pmr::vector<unit *> spine(amount, resource); // Right spine, priorities decreasing from the bottom up.
+        size_t depth = 0;
+        for (size_t i = 0; i < amount; i++)
+        {
+            unit *last = nullptr;
+            nodes[i]->left = nodes[i]->right = nullptr;
+            while (depth && priority(spine[depth - 1]) < priority(nodes[i]))
+                last = spine[--depth];
+            nodes[i]->left = last;
+            if (depth)
+                spine[depth - 1]->right = nodes[i];
+            spine[depth++] = nodes[i];
+        }
+        return spine[0];
+    }
+};
+
+template <typename Balance>
+struct Counted : Balance // The same policy, with `SearchTree::rotations()` counting for it.
+{
+    static constexpr bool counts_rotations = true;
+};
+
+#endif
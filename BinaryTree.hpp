@@ -4,12 +4,16 @@
 #include "defs.hpp"
 #include "Queue.hpp"
 #include "Stack.hpp"
+#include "Balance.hpp"
+#include "FrontCache.hpp"
+#include <vector>
 
 template <typename Any>
 class BinaryTree // Base for all types of binary trees.
 {
 private:
-    Queue<uintptr_t> pointer_record; // Record all using units.
+    Queue<uintptr_t> pointer_record; // Record all using units; those inside the block are tagged with the lowest bit.
+                                     // Its resource and release flag are the tree's as well.
 
 protected:
     typedef char height_t; // Type of `unit::height`.
@@ -17,7 +21,7 @@ protected:
     struct unit
     {
         unsigned int element_count; // Support repeated elements.
-        height_t height;            // The length from buttom to here.
+        height_t height;            // Owned by the balancing policy, the length from buttom to here for AVL.
         unit *left, *right;         // Point to the childs.
         Any element;                // Stored element.
 
@@ -83,28 +87,67 @@ protected:
     template <typename... Args>
     unit *allocate_memory(Args &&...parameters)
     {
-        unit *address = new unit(forward<Args>(parameters)...);
+        void *memory = get_resource()->allocate(sizeof(unit), alignof(unit));
+        unit *address = new (memory) unit(forward<Args>(parameters)...);
         pointer_record.append(reinterpret_cast<uintptr_t>(address));
         return address;
     }
 
+    void free_memory(unit *address)
+    {
+        address->~unit();
+        get_resource()->deallocate(address, sizeof(unit), alignof(unit));
+    }
+
+    unit *allocate_block(size_t amount) // Contiguous room for `amount` units, to be handed to `adopt_block`.
+    {
+        return static_cast<unit *>(get_resource()->allocate(amount * sizeof(unit), alignof(unit)));
+    }
+
+    void adopt_block(unit *block, size_t amount) // Record a block whose units are all constructed; one at a time, after `clear`.
+    {
+        if (this->block)
+            throw "block already adopted";
+        this->block = block, block_amount = amount;
+        for (size_t i = 0; i < amount; i++)
+            pointer_record.append(reinterpret_cast<uintptr_t>(block + i) | 1);
+    }
+
+private:
+    unit *block;         // Units moved together by `relayout`, freed as a whole by `release`.
+    size_t block_amount; // Units in `block`.
+
 protected:
     unit *root;
     size_t element_amount;
 
     void release(void);
+    void clear(void); // Release all units and leave an empty tree.
 
 public:
-    BinaryTree(void) : root() { element_amount = 0, root = nullptr; }
+    BinaryTree(memory_resource *resource = std::pmr::get_default_resource())
+        : pointer_record(resource), block(), root() { block_amount = 0, element_amount = 0, root = nullptr; }
 
     void preorder_traversal(Stack &des) { preorder_traversal_tree(root, des); }
     void inorder_traversal(Stack &des) { inorder_traversal_tree(root, des); }
     void postorder_traversal(Stack &des) { postorder_traversal_tree(root, des); }
 
-    size_t size(void) { return this->element_amount; }
+    size_t size(void) const { return this->element_amount; }
     size_t active_nodes(void) { return pointer_record.length(); }
 
-    ~BinaryTree(void) noexcept { release(); }
+    void skip_release(void)
+    {
+        static_assert(std::is_trivially_destructible_v<Any>, "BinaryTree::skip_release <- Elements need destruction.");
+        pointer_record.skip_release();
+    }
+
+    memory_resource *get_resource(void) const { return pointer_record.get_resource(); }
+
+    ~BinaryTree(void) noexcept
+    {
+        if (pointer_record.is_managed())
+            release();
+    }
 };
 
 template <typename Any>
@@ -152,11 +195,122 @@ void BinaryTree<Any>::postorder_traversal_tree(unit *root, Stack &des)
 template <typename Any>
 void BinaryTree<Any>::release(void)
 {
-    for (auto &pointer : pointer_record)
-        delete reinterpret_cast<unit *>(pointer);
+    uintptr_t pointer;
+    while (pointer_record)
+    {
+        pointer_record >> pointer;
+        if (pointer & 1) // Freed with its block below.
+            reinterpret_cast<unit *>(pointer & ~static_cast<uintptr_t>(1))->~unit();
+        else
+            free_memory(reinterpret_cast<unit *>(pointer));
+    }
+    if (block)
+    {
+        get_resource()->deallocate(block, block_amount * sizeof(unit), alignof(unit));
+        block = nullptr, block_amount = 0;
+    }
 }
 
 template <typename Any>
+void BinaryTree<Any>::clear(void)
+{
+    release();
+    root = nullptr;
+}
+
+template <typename Any, size_t capacity>
+struct InlineBuffer // Sorted contiguous storage for small search trees.
+{
+    Any elements[capacity];
+    unsigned int counts[capacity]; // Same meaning as `unit::element_count`, never zero here.
+    size_t used;
+
+    InlineBuffer(void) : elements() { used = 0; }
+
+    size_t lower_bound(const Any &element) const
+    {
+        size_t position = 0;
+        for (size_t i = 0; i < used; i++)
+            position += static_cast<size_t>(elements[i] < element);
+        return position;
+    }
+    // Branchless scan over the whole buffer, which the compiler vectorizes for arithmetic types.
+
+    bool matches(size_t position, const Any &element) const
+    {
+        return position < used && !(element < elements[position]);
+    }
+
+    template <typename element_t>
+    void insert(size_t position, element_t &&element)
+    {
+        for (size_t i = used; i > position; i--)
+            elements[i] = move(elements[i - 1]), counts[i] = counts[i - 1];
+        elements[position] = forward<element_t>(element);
+        counts[position] = 1;
+        used++;
+    }
+
+    void erase(size_t position)
+    {
+        used--;
+        for (size_t i = position; i < used; i++)
+            elements[i] = move(elements[i + 1]), counts[i] = counts[i + 1];
+    }
+
+    /*
+        Traversals walk the buffer as the balanced tree it would be promoted to,
+        so the output does not depend on the current mode.
+    */
+    void preorder_traversal(size_t low, size_t amount, Stack &des)
+    {
+        if (amount)
+        {
+            size_t middle = amount / 2;
+            des << elements[low + middle];
+            preorder_traversal(low, middle, des);
+            preorder_traversal(low + middle + 1, amount - middle - 1, des);
+        }
+    }
+
+    void inorder_traversal(size_t low, size_t amount, Stack &des)
+    {
+        for (size_t i = low; i < low + amount; i++)
+            des << elements[i];
+    }
+
+    void postorder_traversal(size_t low, size_t amount, Stack &des)
+    {
+        if (amount)
+        {
+            size_t middle = amount / 2;
+            postorder_traversal(low, middle, des);
+            postorder_traversal(low + middle + 1, amount - middle - 1, des);
+            des << elements[low + middle];
+        }
+    }
+};
+
+template <typename Any>
+struct InlineBuffer<Any, 0> // Inline mode disabled.
+{
+};
+
+enum class Layout // Memory order of units after `SearchTree::relayout`.
+{
+    preorder,      // Depth first: a parent is followed by its left subtree.
+    van_emde_boas, // Recursive blocks of half the height, good for every cache size.
+};
+
+/*
+    `inline_threshold` trades per-element units for a fixed buffer of
+    `inline_threshold * (sizeof(Any) + sizeof(unsigned int))` bytes, which every tree carries whether
+    it is empty, inline or promoted. A tree-mode element costs a unit plus its `pointer_record` entry,
+    48 bytes for `int` before allocator overhead. So `SearchTree<int, 32>` (352 bytes, against 88
+    for `SearchTree<int>`) only saves memory for sets of about 6 distinct elements or more, and
+    the threshold is best kept close to the typical set size.
+*/
+template <typename Any, size_t inline_threshold = 0, typename Balance = AVL, size_t cache_slots = 0>
 class SearchTree : public BinaryTree<Any>
 {
 private:
@@ -164,79 +318,300 @@ private:
     typedef typename BinaryTree<Any>::height_t height_t;
     // Define type so that the class could call conveniently.
 
-protected:
-    void _insert(void) {}
+    /*
+        Small-set inline mode.
+        While no more than `inline_threshold` distinct elements are stored, they are kept sorted in
+        `small` and `root` stays null. Going past the threshold moves them into units; removing down
+        to half of it moves them back.
+    */
+    InlineBuffer<Any, inline_threshold> small;
 
-    template <typename first_t, typename... Args>
-    void _insert(first_t &&element, Args &&...rest)
+    /*
+        Optional hot-key cache for `has` and `remove`, off when `cache_slots` is 0.
+        Entries point at units, so reading `element_count` on a hit already reflects every later
+        insert or remove of that element. Any path that frees or moves units must flush it:
+        `relayout`, `clear`, `import_from` and `demote` all do.
+    */
+    FrontCache<unit, cache_slots> cache;
+
+    RotationCounter<Balance::counts_rotations> rotation_amount; // Empty unless `Balance` is `Counted`.
+
+    size_t distinct_amount; // Elements whose count is not zero.
+
+    bool is_inline(void) const { return inline_threshold > 0 && this->root == nullptr; }
+
+    template <typename element_t>
+    bool _insert_inline(element_t &&element)
     {
-        static_assert(is_same_v<decay_t<first_t>, decay_t<Any>>, "SearchTree::_insert <- Wrong type.");
-        this->root = _insert_tree(this->root, forward<first_t>(element));
-        _insert(forward<Args>(rest)...);
+        if constexpr (inline_threshold > 0)
+        {
+            if (this->root)
+                return false;
+
+            size_t position = small.lower_bound(element);
+            if (small.matches(position, element))
+                small.counts[position]++;
+            else if (small.used < inline_threshold)
+                small.insert(position, forward<element_t>(element)), distinct_amount++;
+            else
+            {
+                promote();
+                return false; // Leave the element to `_insert_tree`.
+            }
+            this->element_amount++;
+            return true;
+        }
+        else
+            return false;
     }
 
-    unit *_insert_tree(unit *root, Any &element);
-    unit *_insert_tree(unit *root, Any &&element);
+    bool _remove_inline(Any &element)
+    {
+        if constexpr (inline_threshold > 0)
+        {
+            if (this->root)
+                return false;
+
+            size_t position = small.lower_bound(element);
+            if (small.matches(position, element))
+            {
+                this->element_amount--;
+                if (--small.counts[position] == 0)
+                    small.erase(position), distinct_amount--;
+            }
+            return true;
+        }
+        else
+            return false;
+    }
 
-    static unit *single_rotate_right(unit *root)
+    void promote(void) // Move the inline elements into a balanced tree.
     {
-        unit *tmp = root->right;
-        root->right = tmp->left;
-        tmp->left = root;
-        update_height(root);
-        update_height(tmp);
-        return tmp;
+        unit *nodes[inline_threshold];
+        for (size_t i = 0; i < small.used; i++)
+        {
+            nodes[i] = this->allocate_memory(move(small.elements[i]));
+            nodes[i]->element_count = small.counts[i];
+        }
+        this->root = Balance::build(nodes, small.used, this->get_resource());
+        small.used = 0;
     }
 
-    static unit *single_rotate_left(unit *root)
+    void demote(void) // Move the remaining elements back into `small`, dropping removed units.
     {
-        unit *tmp = root->left;
-        root->left = tmp->right;
-        tmp->right = root;
-        update_height(root);
-        update_height(tmp);
-        return tmp;
+        small.used = 0;
+        gather(this->root);
+        BinaryTree<Any>::clear();
+        cache.flush();
     }
 
-    static unit *double_rotate_right(unit *root)
+    void gather(unit *root)
     {
-        root->right = single_rotate_left(root->right);
-        return single_rotate_right(root);
+        if (root)
+        {
+            gather(root->left);
+            if (root->element_count)
+            {
+                small.elements[small.used] = move(root->element);
+                small.counts[small.used] = root->element_count;
+                small.used++;
+            }
+            gather(root->right);
+        }
     }
 
-    static unit *double_rotate_left(unit *root)
+    static void export_tree(unit *root, Any *&des, bool repeated) // In order, skipping removed units.
     {
-        root->left = single_rotate_right(root->left);
-        return single_rotate_left(root);
+        if (root)
+        {
+            export_tree(root->left, des, repeated);
+            for (unsigned int i = 0; i < ((repeated) ? root->element_count : (root->element_count != 0)); i++)
+                *des++ = root->element;
+            export_tree(root->right, des, repeated);
+        }
+    }
+
+    static void export_tree(unit *root, Any *&des, unsigned int *&counts)
+    {
+        if (root)
+        {
+            export_tree(root->left, des, counts);
+            if (root->element_count)
+                *des++ = root->element, *counts++ = root->element_count;
+            export_tree(root->right, des, counts);
+        }
+    }
+
+    static void collect(unit *root, unit **&des) // Units in use, in order.
+    {
+        if (root)
+        {
+            collect(root->left, des);
+            if (root->element_count)
+                *des++ = root;
+            collect(root->right, des);
+        }
+    }
+
+    static void preorder_layout(unit *root, unit **&des)
+    {
+        if (root)
+        {
+            *des++ = root;
+            preorder_layout(root->left, des);
+            preorder_layout(root->right, des);
+        }
+    }
+
+    static void van_emde_boas_layout(unit *root, size_t levels, unit **&des)
+    {
+        if (root == nullptr || levels == 0)
+            return;
+        if (levels == 1)
+        {
+            *des++ = root;
+            return;
+        }
+
+        size_t top = levels / 2;
+        van_emde_boas_layout(root, top, des);
+        van_emde_boas_bottoms(root, top, levels - top, des);
+    }
+
+    static void van_emde_boas_bottoms(unit *root, size_t depth, size_t levels, unit **&des) // Subtrees `depth` below, left to right.
+    {
+        if (root == nullptr)
+            return;
+        if (depth == 0)
+            return van_emde_boas_layout(root, levels, des);
+        van_emde_boas_bottoms(root->left, depth - 1, levels, des);
+        van_emde_boas_bottoms(root->right, depth - 1, levels, des);
+    }
+
+    template <typename visitor_t>
+    static void scan_tree(unit *root, const Any &low, const Any &high, visitor_t &visit)
+    {
+        if (root)
+        {
+            if (low < root->element)
+                scan_tree(root->left, low, high, visit);
+            if (root->element_count && !(root->element < low) && root->element < high)
+                visit(root->element, root->element_count);
+            if (root->element < high)
+                scan_tree(root->right, low, high, visit);
+        }
+    }
+
+    void build_sorted(const Any *src, size_t amount) // Fill an empty tree from sorted `src`.
+    {
+        size_t distinct = 0;
+        for (size_t i = 0; i < amount; i++)
+            distinct += (i == 0 || src[i - 1] < src[i]);
+
+        if (inline_threshold > 0 && distinct <= inline_threshold)
+        {
+            if constexpr (inline_threshold > 0)
+            {
+                for (size_t i = 0; i < amount; i++)
+                {
+                    if (i && !(src[i - 1] < src[i]))
+                        small.counts[small.used - 1]++;
+                    else
+                        small.elements[small.used] = src[i], small.counts[small.used++] = 1;
+                }
+            }
+        }
+        else
+        {
+            std::pmr::vector<unit *> nodes(distinct, this->get_resource());
+            size_t used = 0;
+            for (size_t i = 0; i < amount; i++)
+            {
+                if (i && !(src[i - 1] < src[i]))
+                    nodes[used - 1]->element_count++;
+                else
+                {
+                    nodes[used] = this->allocate_memory(src[i]);
+                    nodes[used++]->element_count = 1;
+                }
+            }
+            this->root = Balance::build(nodes.data(), distinct, this->get_resource());
+        }
+        this->element_amount = amount, distinct_amount = distinct;
     }
 
-    static height_t measure_height(unit *root) { return (root) ? root->height : -1; }
+protected:
+    void _insert(void) {}
 
-    static void update_height(unit *root)
+    template <typename first_t, typename... Args>
+    void _insert(first_t &&element, Args &&...rest)
     {
-        root->height = (measure_height(root->left) > measure_height(root->right)) ? measure_height(root->left) + 1 : measure_height(root->right) + 1;
+        static_assert(is_same_v<decay_t<first_t>, decay_t<Any>>, "SearchTree::_insert <- Wrong type.");
+        if (!_insert_inline(forward<first_t>(element)))
+            this->root = Balance::finish(_insert_tree(this->root, forward<first_t>(element)));
+        _insert(forward<Args>(rest)...);
     }
 
+    unit *_insert_tree(unit *root, Any &element);
+    unit *_insert_tree(unit *root, Any &&element);
+
 protected:
     static unit *find(unit *root, Any &element);
 
+    unit *lookup(Any &element) // `find` behind the front cache.
+    {
+        if constexpr (cache_slots > 0)
+        {
+            unit *result = cache.lookup(element);
+            if (result == nullptr)
+            {
+                result = find(this->root, element);
+                if (result)
+                    cache.fill(element, result);
+            }
+            return (result && result->element_count) ? result : nullptr;
+        }
+        else
+            return find(this->root, element);
+    }
+
     void _remove(void) {}
 
     template <typename first_t, typename... Args>
     void _remove(first_t &&element, Args &&...rest)
     {
         static_assert(is_same_v<decay_t<first_t>, decay_t<Any>>, "SearchTree::_remove <- Wrong type.");
-        unit *result = find(this->root, element);
-        if (result)
-            result->element_count--, this->element_amount--;
+        if (!_remove_inline(element))
+        {
+            unit *result = lookup(element);
+            if (result)
+            {
+                result->element_count--, this->element_amount--;
+                if (result->element_count == 0)
+                {
+                    distinct_amount--;
+                    if constexpr (inline_threshold > 0)
+                        if (distinct_amount <= inline_threshold / 2)
+                            demote();
+                }
+            }
+        }
         _remove(forward<Args>(rest)...);
     }
 
 public:
-    SearchTree(void) : BinaryTree<Any>() {}
+    SearchTree(void) : BinaryTree<Any>() { distinct_amount = 0; }
 
-    template <typename... Args>
-    SearchTree(Args &&...elements) : BinaryTree<Any>() { insert(forward<Args>(elements)...); }
+    template <typename first_t, typename... Args>
+    SearchTree(first_t &&first, Args &&...elements) : BinaryTree<Any>(select_resource(first))
+    {
+        distinct_amount = 0;
+        if constexpr (std::is_convertible_v<first_t, memory_resource *>)
+            insert(forward<Args>(elements)...);
+        else
+            insert(forward<first_t>(first), forward<Args>(elements)...);
+    }
+    // `first` may be a `memory_resource *`, see `select_resource`.
 
     template <typename... Args>
     void insert(Args &&...elements) { _insert(forward<Args>(elements)...); }
@@ -244,89 +619,294 @@ public:
     template <typename... Args>
     void remove(Args &&...elements) { _remove(forward<Args>(elements)...); }
 
-    bool has(Any &element) { return static_cast<bool>(find(this->root, element)); }
+    bool has(Any &element)
+    {
+        if constexpr (inline_threshold > 0)
+            if (is_inline())
+                return small.matches(small.lower_bound(element), element);
+        return static_cast<bool>(lookup(element));
+    }
     bool has(Any &&element) { return this->has(element); }
 
-    size_t height(void) { return static_cast<size_t>(this->root->height); }
+    void preorder_traversal(Stack &des)
+    {
+        if constexpr (inline_threshold > 0)
+            if (is_inline())
+                return small.preorder_traversal(0, small.used, des);
+        BinaryTree<Any>::preorder_traversal(des);
+    }
+
+    void inorder_traversal(Stack &des)
+    {
+        if constexpr (inline_threshold > 0)
+            if (is_inline())
+                return small.inorder_traversal(0, small.used, des);
+        BinaryTree<Any>::inorder_traversal(des);
+    }
+
+    void postorder_traversal(Stack &des)
+    {
+        if constexpr (inline_threshold > 0)
+            if (is_inline())
+                return small.postorder_traversal(0, small.used, des);
+        BinaryTree<Any>::postorder_traversal(des);
+    }
+
+    size_t height(void)
+    {
+        if constexpr (inline_threshold > 0)
+            if (is_inline())
+            {
+                size_t result = 0;
+                for (size_t amount = small.used; amount > 1; amount /= 2)
+                    result++;
+                return result;
+            }
+        return Balance::height(this->root);
+    }
+
+    size_t rotations(void) const { return rotation_amount.value(); } // Always 0 unless `Balance` is `Counted`.
+
+    size_t cache_hits(void) const { return cache.hits(); }
+    size_t cache_misses(void) const { return cache.misses(); }
+
+    size_t distinct_size(void) const { return distinct_amount; }
+
+    void clear(void) // Remove every element and release all units.
+    {
+        BinaryTree<Any>::clear();
+        cache.flush();
+        if constexpr (inline_threshold > 0)
+            small.used = 0;
+        this->element_amount = distinct_amount = 0;
+    }
+
+    /*
+        Move all units in use into one contiguous block, in `order`, and free removed units.
+        The tree is rebuilt balanced first and stays fully usable afterwards; new units are
+        allocated one by one as before. Small enough trees go back to inline mode instead.
+    */
+    void relayout(Layout order = Layout::van_emde_boas);
+
+    template <typename visitor_t>
+    void scan(const Any &low, const Any &high, visitor_t &&visit)
+    {
+        if constexpr (inline_threshold > 0)
+            if (is_inline())
+            {
+                for (size_t i = small.lower_bound(low); i < small.used && small.elements[i] < high; i++)
+                    visit(small.elements[i], small.counts[i]);
+                return;
+            }
+        scan_tree(this->root, low, high, visit);
+    }
+    // Call `visit(element, count)` for every element in [low, high), in ascending order.
+
+    /*
+        Bulk export in ascending order into a caller-provided buffer.
+        `repeated` writes every element as many times as it was inserted, so `capacity` must be at
+        least `size()`; otherwise each element is written once and `distinct_size()` is enough.
+        Return the number of elements written.
+    */
+    size_t export_into(Any *des, size_t capacity, bool repeated = false)
+    {
+        size_t amount = (repeated) ? this->element_amount : distinct_amount;
+        if (capacity < amount)
+            throw "buffer too small";
+        if (amount == 0)
+            return 0;
+
+        if constexpr (inline_threshold > 0)
+            if (is_inline())
+            {
+                if constexpr (std::is_trivially_copyable_v<Any>)
+                    if (!repeated)
+                    {
+                        memcpy(des, small.elements, amount * sizeof(Any));
+                        return amount;
+                    }
+                for (size_t i = 0; i < small.used; i++)
+                    for (unsigned int j = 0; j < ((repeated) ? small.counts[i] : 1); j++)
+                        *des++ = small.elements[i];
+                return amount;
+            }
+        export_tree(this->root, des, repeated);
+        return amount;
+    }
+
+    size_t export_into(Any *des, unsigned int *counts, size_t capacity) // Distinct elements with their counts.
+    {
+        if (capacity < distinct_amount)
+            throw "buffer too small";
+        if (distinct_amount == 0)
+            return 0;
+
+        if constexpr (inline_threshold > 0)
+            if (is_inline())
+            {
+                if constexpr (std::is_trivially_copyable_v<Any>)
+                    memcpy(des, small.elements, small.used * sizeof(Any));
+                else
+                    for (size_t i = 0; i < small.used; i++)
+                        des[i] = small.elements[i];
+                memcpy(counts, small.counts, small.used * sizeof(unsigned int));
+                return distinct_amount;
+            }
+        export_tree(this->root, des, counts);
+        return distinct_amount;
+    }
+
+    std::vector<Any> to_sorted_vector(bool repeated = false)
+    {
+        std::vector<Any> result((repeated) ? this->element_amount : distinct_amount);
+        export_into(result.data(), result.size(), repeated);
+        return result;
+    }
+
+    /*
+        Bulk import. An empty tree given sorted input is built directly in linear time,
+        otherwise the elements are inserted one by one.
+    */
+    void import_from(const Any *src, size_t amount)
+    {
+        bool sorted = (this->element_amount == 0);
+        for (size_t i = 1; sorted && i < amount; i++)
+            sorted = !(src[i] < src[i - 1]);
+
+        if (sorted)
+        {
+            if (this->root) // Only removed units are left.
+                BinaryTree<Any>::clear(), cache.flush();
+            build_sorted(src, amount);
+        }
+        else
+            for (size_t i = 0; i < amount; i++)
+            {
+                Any element = src[i];
+                _insert(element);
+            }
+    }
 };
 
-template <typename Any>
-typename SearchTree<Any>::unit *
-SearchTree<Any>::_insert_tree(unit *root, Any &element)
+template <typename Any, size_t inline_threshold, typename Balance, size_t cache_slots>
+typename SearchTree<Any, inline_threshold, Balance, cache_slots>::unit *
+SearchTree<Any, inline_threshold, Balance, cache_slots>::_insert_tree(unit *root, Any &element)
 {
     if (root == nullptr)
     {
         root = this->allocate_memory(element);
-        this->element_amount++;
+        this->element_amount++, distinct_amount++;
         root->element_count = 1;
+        Balance::initialize(root);
     }
     else
     {
         if (root->element < element)
         {
             root->right = _insert_tree(root->right, element);
-            if (measure_height(root->right) - measure_height(root->left) == 2)
-                if (root->right->element < element)
-                    root = single_rotate_right(root);
-                else
-                    root = double_rotate_right(root);
+            root = Balance::grown_right(root, rotation_amount);
         }
         else if (root->element > element)
         {
             root->left = _insert_tree(root->left, element);
-            if (measure_height(root->left) - measure_height(root->right) == 2)
-                if (root->left->element > element)
-                    root = single_rotate_left(root);
-                else
-                    root = double_rotate_left(root);
+            root = Balance::grown_left(root, rotation_amount);
         }
         else
+        {
+            if (root->element_count == 0)
+                distinct_amount++; // Revive a removed unit.
             root->element_count++, this->element_amount++;
+        }
     }
-    update_height(root);
     return root;
 }
 
-template <typename Any>
-typename SearchTree<Any>::unit *
-SearchTree<Any>::_insert_tree(unit *root, Any &&element)
+template <typename Any, size_t inline_threshold, typename Balance, size_t cache_slots>
+typename SearchTree<Any, inline_threshold, Balance, cache_slots>::unit *
+SearchTree<Any, inline_threshold, Balance, cache_slots>::_insert_tree(unit *root, Any &&element)
 {
     if (root == nullptr)
     {
         root = this->allocate_memory(forward<Any>(element));
-        this->element_amount++;
+        this->element_amount++, distinct_amount++;
         root->element_count = 1;
+        Balance::initialize(root);
     }
     else
     {
         if (root->element < element)
         {
             root->right = _insert_tree(root->right, forward<Any>(element));
-            if (measure_height(root->right) - measure_height(root->left) == 2)
-                if (root->right->element < element)
-                    root = single_rotate_right(root);
-                else
-                    root = double_rotate_right(root);
+            root = Balance::grown_right(root, rotation_amount);
         }
         else if (root->element > element)
         {
             root->left = _insert_tree(root->left, forward<Any>(element));
-            if (measure_height(root->left) - measure_height(root->right) == 2)
-                if (root->left->element > element)
-                    root = single_rotate_left(root);
-                else
-                    root = double_rotate_left(root);
+            root = Balance::grown_left(root, rotation_amount);
         }
         else
+        {
+            if (root->element_count == 0)
+                distinct_amount++; // Revive a removed unit.
             root->element_count++, this->element_amount++;
+        }
     }
-    update_height(root);
     return root;
 }
 
-template <typename Any>
-typename SearchTree<Any>::unit *SearchTree<Any>::find(unit *root, Any &element)
+template <typename Any, size_t inline_threshold, typename Balance, size_t cache_slots>
+void SearchTree<Any, inline_threshold, Balance, cache_slots>::relayout(Layout order)
 {
+    if (this->root == nullptr)
+        return;
+    if constexpr (inline_threshold > 0)
+        if (distinct_amount <= inline_threshold)
+            return demote();
+    if (distinct_amount == 0)
+        return clear();
+
+    std::pmr::vector<unit *> sorted(distinct_amount, this->get_resource());
+    unit **end = sorted.data();
+    collect(this->root, end);
+    unit *root = Balance::build(sorted.data(), distinct_amount, this->get_resource()); // Relink the old units into the final shape.
+
+    end = sorted.data();
+    if (order == Layout::preorder)
+        preorder_layout(root, end);
+    else
+        van_emde_boas_layout(root, Balance::height(root) + 1, end);
+
+    /*
+        Copy each unit to its place in the block, leaving the new address in the old unit's `right`,
+        then translate the children, which still point at old units.
+    */
+    unit *block = this->allocate_block(distinct_amount);
+    for (size_t i = 0; i < distinct_amount; i++)
+    {
+        new (block + i) unit(move(*sorted[i]));
+        sorted[i]->right = block + i;
+    }
+    for (size_t i = 0; i < distinct_amount; i++)
+    {
+        if (block[i].left)
+            block[i].left = block[i].left->right;
+        if (block[i].right)
+            block[i].right = block[i].right->right;
+    }
+    root = root->right;
+
+    BinaryTree<Any>::clear(); // Free the old units and block.
+    this->adopt_block(block, distinct_amount);
+    cache.flush();
+    this->root = root;
+}
+
+template <typename Any, size_t inline_threshold, typename Balance, size_t cache_slots>
+typename SearchTree<Any, inline_threshold, Balance, cache_slots>::unit *SearchTree<Any, inline_threshold, Balance, cache_slots>::find(unit *root, Any &element)
+{
+    if (root == nullptr) // Empty tree.
+        return nullptr;
+
     if (root->element > element)
     {
         if (root->left)
@@ -345,4 +925,87 @@ typename SearchTree<Any>::unit *SearchTree<Any>::find(unit *root, Any &element)
         return (root->element_count) ? root : nullptr;
 }
 
+/*
+    Search tree that logs every operation into a `TraceRecorder`.
+    Kept apart from `SearchTree` so other trees carry no recorder and check nothing per operation.
+*/
+template <typename Any, size_t inline_threshold = 0, typename Balance = AVL, size_t cache_slots = 0>
+class TracedSearchTree : public SearchTree<Any, inline_threshold, Balance, cache_slots>
+{
+private:
+    typedef SearchTree<Any, inline_threshold, Balance, cache_slots> tree_t;
+
+    TraceRecorder *recorder; // Log operations here if not null.
+
+    template <typename element_t>
+    void insert_one(element_t &&element)
+    {
+        if (recorder)
+            recorder->record(TraceOperation::insert, element);
+        tree_t::insert(forward<element_t>(element));
+    }
+
+    template <typename element_t>
+    void remove_one(element_t &&element)
+    {
+        if (recorder)
+            recorder->record(TraceOperation::remove, element);
+        tree_t::remove(forward<element_t>(element));
+    }
+
+public:
+    TracedSearchTree(memory_resource *resource = std::pmr::get_default_resource()) : tree_t(resource) { recorder = nullptr; }
+
+    template <typename... Args>
+    void insert(Args &&...elements) { (insert_one(forward<Args>(elements)), ...); }
+
+    template <typename... Args>
+    void remove(Args &&...elements) { (remove_one(forward<Args>(elements)), ...); }
+
+    bool has(Any &element)
+    {
+        if (recorder)
+            recorder->record(TraceOperation::has, element);
+        return tree_t::has(element);
+    }
+    bool has(Any &&element) { return this->has(element); }
+
+    void preorder_traversal(Stack &des)
+    {
+        if (recorder)
+            recorder->record(TraceOperation::preorder_traversal);
+        tree_t::preorder_traversal(des);
+    }
+
+    void inorder_traversal(Stack &des)
+    {
+        if (recorder)
+            recorder->record(TraceOperation::inorder_traversal);
+        tree_t::inorder_traversal(des);
+    }
+
+    void postorder_traversal(Stack &des)
+    {
+        if (recorder)
+            recorder->record(TraceOperation::postorder_traversal);
+        tree_t::postorder_traversal(des);
+    }
+
+    void import_from(const Any *src, size_t amount) // Logged as one insertion per element.
+    {
+        if (recorder)
+            for (size_t i = 0; i < amount; i++)
+                recorder->record(TraceOperation::insert, src[i]);
+        tree_t::import_from(src, amount);
+    }
+
+    void trace(TraceRecorder *recorder)
+    {
+        if (recorder)
+            recorder->bind<Any>();
+        this->recorder = recorder;
+    }
+    // Record every operation into `recorder`, or stop recording with null.
+};
+
 #endif
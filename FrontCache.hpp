@@ -0,0 +1,84 @@
+#ifndef _FRONTCACHE_HEADER
+#define _FRONTCACHE_HEADER
+
+#include "defs.hpp"
+#include <functional>
+
+/*
+    Two-way set-associative cache from an element to the unit holding it, placed in front of
+    `SearchTree::find`. Sets are chosen by the element hash and each set keeps its most recently
+    used unit first. Entries are raw unit pointers, so any path that frees or moves units must call
+    `flush`; in `SearchTree` that is `relayout`, `clear`, `import_from` and `demote`.
+*/
+template <typename node_t, size_t slot_amount>
+class FrontCache
+{
+private:
+    static_assert(slot_amount >= 2 && (slot_amount & (slot_amount - 1)) == 0, "FrontCache <- Slots must be a power of two.");
+
+    static constexpr size_t set_amount = slot_amount / 2;
+
+    struct set
+    {
+        node_t *way[2];
+    };
+
+    alignas(64) set sets[set_amount];
+    size_t hit_amount, miss_amount;
+
+    template <typename Any>
+    static set &locate(set *sets, const Any &element)
+    {
+        uint64_t hash = mix_bits(static_cast<uint64_t>(std::hash<Any>()(element)));
+        return sets[hash & (set_amount - 1)];
+    }
+
+    template <typename Any>
+    static bool holds(node_t *node, const Any &element)
+    {
+        return node && !(node->element > element) && !(node->element < element);
+    }
+
+public:
+    FrontCache(void) { flush(), hit_amount = miss_amount = 0; }
+
+    template <typename Any>
+    node_t *lookup(const Any &element) // Null on a miss.
+    {
+        set &target = locate(sets, element);
+        if (holds(target.way[0], element))
+            return hit_amount++, target.way[0];
+        if (holds(target.way[1], element))
+        {
+            node_t *node = target.way[1];
+            target.way[1] = target.way[0], target.way[0] = node;
+            return hit_amount++, node;
+        }
+        miss_amount++;
+        return nullptr;
+    }
+
+    template <typename Any>
+    void fill(const Any &element, node_t *node)
+    {
+        set &target = locate(sets, element);
+        target.way[1] = target.way[0], target.way[0] = node;
+    }
+
+    void flush(void) { memset(sets, 0, sizeof(sets)); }
+
+    size_t hits(void) const { return hit_amount; }
+    size_t misses(void) const { return miss_amount; }
+};
+
+template <typename node_t>
+class FrontCache<node_t, 0> // Cache disabled.
+{
+public:
+    void flush(void) {}
+
+    size_t hits(void) const { return 0; }
+    size_t misses(void) const { return 0; }
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define _QUEUE_HEADER
 
 #include "defs.hpp"
+#include "Trace.hpp"
 
 template <typename Any>
 class Queue
@@ -24,6 +25,22 @@ private:
     size_t element_amount;
     unit *start, *tail;
 
+    memory_resource *resource; // Source of all units.
+    bool managed;              // Whether the deconstructor has to release units.
+
+    template <typename... Args>
+    unit *create(Args &&...parameters)
+    {
+        void *address = resource->allocate(sizeof(unit), alignof(unit));
+        return new (address) unit(forward<Args>(parameters)...);
+    }
+
+    void destroy(unit *address)
+    {
+        address->~unit();
+        resource->deallocate(address, sizeof(unit), alignof(unit));
+    }
+
 public:
     class Iterator // Forward only.
     {
@@ -81,16 +98,24 @@ public:
     {
         element_amount = 0;
         start = tail = nullptr;
+        resource = std::pmr::get_default_resource();
+        managed = true;
     }
 
-    template <typename... Args>
-    Queue(Args &&...parameters) // A more powerful constructor.
+    template <typename first_t, typename... Args>
+    Queue(first_t &&first, Args &&...parameters) // A more powerful constructor.
     {
         element_amount = 0;
         start = tail = nullptr;
+        resource = select_resource(first);
+        managed = true;
 
-        _append(forward<Args>(parameters)...); // Recursive call.
+        if constexpr (std::is_convertible_v<first_t, memory_resource *>)
+            _append(forward<Args>(parameters)...); // Recursive call.
+        else
+            _append(forward<first_t>(first), forward<Args>(parameters)...);
     }
+    // `first` may be a `memory_resource *`, see `select_resource`.
 
     Queue(const Queue &queue); // Copy constructor for Queue.
     Queue(Queue &&other)
@@ -98,6 +123,8 @@ public:
         element_amount = other.element_amount;
         start = other.start;
         tail = other.tail;
+        resource = other.resource;
+        managed = other.managed;
 
         other.element_amount = 0;
         other.start = other.tail = nullptr; // Avoid calling deconstructor unexpectedly.
@@ -116,6 +143,8 @@ public:
         element_amount = other.element_amount;
         start = other.start;
         tail = other.tail;
+        resource = other.resource;
+        managed = other.managed;
 
         other.element_amount = 0;
         other.start = other.tail = nullptr; // Avoid calling deconstructor unexpectedly.
@@ -148,6 +177,12 @@ public:
     Queue &operator>>(Any &out);
     // Pop an element if the queue is not empty.
 
+    Queue &import_from(const Any *src, size_t amount);
+    // Append `amount` elements from a contiguous buffer.
+
+    size_t export_into(Any *des, size_t capacity);
+    // Copy the elements in order into a buffer of at least `length()` elements, keeping them queued.
+
     Any &operator[](unsigned int offset);
     // Get a reference to a certain element.
 
@@ -159,7 +194,20 @@ public:
     // We can use the object directly when computing logical expressions.
     // Return false if empty, or it will return true.
 
-    ~Queue(void) noexcept { release(); } // Call deconstructor.
+    void skip_release(void)
+    {
+        static_assert(std::is_trivially_destructible_v<Any>, "Queue::skip_release <- Elements need destruction.");
+        managed = false;
+    }
+
+    bool is_managed(void) const { return managed; } // False after `skip_release`.
+    memory_resource *get_resource(void) const { return resource; }
+
+    ~Queue(void) noexcept
+    {
+        if (managed)
+            release(); // Call deconstructor.
+    }
 };
 
 template <typename Any>
@@ -190,6 +238,8 @@ Queue<Any>::Queue(const Queue<Any> &other)
 {
     element_amount = 0;
     start = tail = nullptr;
+    resource = std::pmr::get_default_resource();
+    managed = true;
 
     unit *iter = other.start;
     for (int i = 0; i < other.element_amount; i++, iter = iter->next)
@@ -201,6 +251,8 @@ Queue<Any>::Queue(std::initializer_list<Any> list)
 {
     element_amount = 0;
     start = tail = nullptr;
+    resource = std::pmr::get_default_resource();
+    managed = true;
 
     auto iterator = list.begin();
     for (int i = 0; i < list.size(); i++)
@@ -215,7 +267,7 @@ Queue<Any> &Queue<Any>::append(Any &in)
 {
     if (element_amount == 0) // The first element appended to the chain list.
     {
-        start = new unit;
+        start = create();
 
         start->data = in;
         start->next = start;
@@ -225,7 +277,7 @@ Queue<Any> &Queue<Any>::append(Any &in)
     }
     else
     {
-        unit *temp = new unit;
+        unit *temp = create();
         temp->data = in;
         temp->next = start;
 
@@ -242,7 +294,7 @@ Queue<Any> &Queue<Any>::append(Any &&in)
 {
     if (element_amount == 0) // The first element appended to the chain list.
     {
-        start = new unit;
+        start = create();
 
         start->data = forward<Any>(in);
         start->next = start;
@@ -252,7 +304,7 @@ Queue<Any> &Queue<Any>::append(Any &&in)
     }
     else
     {
-        unit *temp = new unit;
+        unit *temp = create();
         temp->data = forward<Any>(in);
         temp->next = start;
 
@@ -274,11 +326,38 @@ Queue<Any> &Queue<Any>::operator>>(Any &out)
     out = move(start->data);
     start = temp->next;
 
-    delete temp;
+    destroy(temp);
     element_amount--;
+    if (element_amount == 0)
+        start = tail = nullptr; // Keep `release` away from the freed unit.
+    else
+        tail->next = start;
+    return *this;
+}
+
+template <typename Any>
+Queue<Any> &Queue<Any>::import_from(const Any *src, size_t amount)
+{
+    for (size_t i = 0; i < amount; i++)
+    {
+        Any element = src[i];
+        append(move(element));
+    }
     return *this;
 }
 
+template <typename Any>
+size_t Queue<Any>::export_into(Any *des, size_t capacity)
+{
+    if (capacity < element_amount)
+        throw "buffer too small";
+
+    unit *iter = start;
+    for (size_t i = 0; i < element_amount; i++, iter = iter->next)
+        des[i] = iter->data;
+    return element_amount;
+}
+
 template <typename Any>
 Any &Queue<Any>::operator[](unsigned int offset)
 {
@@ -302,10 +381,10 @@ void Queue<Any>::release(void)
         {
             temp = iter;
             iter = iter->next;
-            delete temp;
+            destroy(temp);
         }
 
-        delete iter;
+        destroy(iter);
     }
 }
 
@@ -337,4 +416,63 @@ void print(Queue<Any> &queue) // Override for public output interface.
         putchar(']');
 }
 
+/*
+    Queue that logs `append` and pop operations into a `TraceRecorder`.
+    Kept apart from `Queue` so queues used for internal bookkeeping carry no recorder.
+*/
+template <typename Any>
+class TracedQueue : public Queue<Any>
+{
+private:
+    TraceRecorder *recorder; // Log operations here if not null.
+
+    template <typename element_t>
+    void append_one(element_t &&element)
+    {
+        static_assert(is_same_v<decay_t<element_t>, decay_t<Any>>, "TracedQueue::append <- Wrong type.");
+        if (recorder)
+            recorder->record(TraceOperation::append, element);
+        Queue<Any>::append(forward<element_t>(element));
+    }
+
+public:
+    TracedQueue(memory_resource *resource = std::pmr::get_default_resource()) : Queue<Any>(resource) { recorder = nullptr; }
+
+    template <typename... Args>
+    TracedQueue &append(Args &&...elements)
+    {
+        (append_one(forward<Args>(elements)), ...);
+        return *this;
+    }
+
+    template <typename element_t>
+    TracedQueue &operator<<(element_t &&in) { return append(forward<element_t>(in)); }
+
+    TracedQueue &operator>>(Any &out)
+    {
+        if (recorder && this->length())
+            recorder->record(TraceOperation::pop);
+        Queue<Any>::operator>>(out);
+        return *this;
+    }
+
+    TracedQueue &import_from(const Any *src, size_t amount)
+    {
+        for (size_t i = 0; i < amount; i++)
+        {
+            Any element = src[i];
+            append_one(move(element));
+        }
+        return *this;
+    }
+
+    void trace(TraceRecorder *recorder)
+    {
+        if (recorder)
+            recorder->bind<Any>();
+        this->recorder = recorder;
+    }
+    // Record `append` and pop operations into `recorder`, or stop recording with null.
+};
+
 #endif
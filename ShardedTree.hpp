@@ -0,0 +1,415 @@
+#ifndef _SHARDEDTREE_HEADER
+#define _SHARDEDTREE_HEADER
+
+#include "BinaryTree.hpp"
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/*
+    Thread-safe search tree split by key range into independent `Tree` shards.
+    Each shard has its own lock and its own pool resource, so writers to different ranges never
+    contend on a lock or on the allocator. Split points follow the data: a shard that grows past
+    the limit is split into a spare shard, or has its boundary moved toward a lighter neighbour,
+    touching only those two shards. Only when neither helps are all shards redistributed at the
+    quantiles of the stored elements, and the limit is raised so that happens rarely.
+
+    Locking: the ranges live in an immutable `layout_t` published through `current`. An operation
+    routes with a snapshot of it, locks the shard, and retries if a newer layout was published
+    meanwhile. Every change of ranges holds `reshape_lock` and the locks of the shards it moves
+    elements between, and publishes a new layout before releasing them. While routing, a reader
+    counts itself in the stripe of its thread; `publish` frees the replaced layout once every
+    stripe has drained, so only one layout is ever kept. Routing takes no lock, so the wait is short.
+*/
+template <typename Any, size_t shard_amount = 16, typename Tree = SearchTree<Any>>
+class ShardedSearchTree
+{
+private:
+    static_assert(shard_amount > 0, "ShardedSearchTree <- At least one shard.");
+
+    static constexpr size_t minimum_limit = 1024; // No reshaping below this shard size.
+    static constexpr size_t stripe_amount = 16;   // Reader counters; more threads than this share them.
+
+    struct alignas(64) shard
+    {
+        std::mutex lock;
+        std::pmr::unsynchronized_pool_resource pool; // Guarded by `lock` like the tree.
+        Tree tree;
+
+        shard(void) : tree(&pool) {}
+    };
+
+    struct alignas(64) stripe
+    {
+        std::atomic<size_t> readers{0}; // Threads of this stripe routing right now.
+    };
+
+    struct layout_t
+    {
+        size_t version;              // Bumped by every `publish`; compared instead of addresses, which get reused.
+        size_t active_amount;        // Ranges in use.
+        size_t shard_of[shard_amount]; // Shard holding each range, in key order.
+        Any bounds[shard_amount];    // Range `i` is [bounds[i - 1], bounds[i]); only the first `active_amount - 1` are used.
+    };
+
+    shard shards[shard_amount];
+    mutable stripe stripes[stripe_amount];
+
+    alignas(64) std::atomic<const layout_t *> current; // Read by every operation, written only when reshaping.
+    std::atomic<size_t> published;                     // Version of `current`, checked under a shard lock.
+    std::atomic<size_t> rebalance_limit;               // Size of a shard that triggers reshaping.
+    std::atomic<size_t> rebalance_amount;              // Full redistributions so far.
+
+    std::mutex reshape_lock; // Serializes changes of ranges and cross-shard reads.
+
+    static size_t route(const layout_t *layout, const Any &element) // First range whose upper bound exceeds `element`.
+    {
+        size_t low = 0, high = layout->active_amount - 1;
+        while (low < high)
+        {
+            size_t middle = (low + high) / 2;
+            if (element < layout->bounds[middle])
+                high = middle;
+            else
+                low = middle + 1;
+        }
+        return low;
+    }
+
+    static size_t own_stripe(void)
+    {
+        static std::atomic<size_t> next_stripe(0);
+        thread_local size_t index = next_stripe.fetch_add(1, std::memory_order_relaxed) % stripe_amount;
+        return index;
+    }
+
+    template <typename read_t>
+    auto read_layout(read_t &&read) const // Return `read(snapshot)`; the snapshot must not be kept after it.
+    {
+        std::atomic<size_t> &readers = stripes[own_stripe()].readers;
+        readers.fetch_add(1); // Sequentially consistent, paired with the store in `publish`.
+        auto result = read(current.load());
+        readers.fetch_sub(1, std::memory_order_release);
+        return result;
+    }
+
+    template <typename work_t>
+    auto locked(const Any &element, work_t &&work) // Run `work(target)` on the shard holding `element`, under its lock.
+    {
+        while (true)
+        {
+            auto [version, index] = read_layout([&](const layout_t *snapshot)
+                                                { return std::make_pair(snapshot->version,
+                                                                        snapshot->shard_of[route(snapshot, element)]); });
+            shard &target = shards[index];
+            std::lock_guard<std::mutex> lock(target.lock);
+            if (published.load(std::memory_order_acquire) == version) // Ranges moved meanwhile: route again.
+                return work(target);
+        }
+    }
+
+    size_t shard_size(size_t index)
+    {
+        std::lock_guard<std::mutex> lock(shards[index].lock);
+        return shards[index].tree.size();
+    }
+
+    void publish(const layout_t &next) // Call with `reshape_lock` and the locks of every shard whose range changed.
+    {
+        const layout_t *replaced = current.load(std::memory_order_relaxed);
+        layout_t *fresh = new layout_t(next);
+        fresh->version = (replaced) ? replaced->version + 1 : 0;
+        current.store(fresh); // Readers counted from now on see `fresh`.
+        published.store(fresh->version, std::memory_order_release);
+
+        for (auto &counted : stripes) // Wait out readers that may still be routing with `replaced`.
+            while (counted.readers.load() != 0)
+                std::this_thread::yield();
+        delete replaced;
+    }
+
+    bool regroup(layout_t &next, size_t position, bool merge);
+    void reshape(const Any &element);
+    void redistribute(void);
+
+public:
+    ShardedSearchTree(void) : current(nullptr)
+    {
+        layout_t first = {};
+        first.active_amount = 1;
+        for (size_t i = 0; i < shard_amount; i++)
+            first.shard_of[i] = i;
+        publish(first);
+        rebalance_limit = minimum_limit;
+        rebalance_amount = 0;
+    }
+
+    ShardedSearchTree(const ShardedSearchTree &other) = delete;
+
+    ~ShardedSearchTree(void) { delete current.load(std::memory_order_relaxed); }
+
+    template <typename... Args>
+    void insert(Args &&...elements) { (insert_one(forward<Args>(elements)), ...); }
+
+    template <typename... Args>
+    void remove(Args &&...elements) { (remove_one(forward<Args>(elements)), ...); }
+
+    void insert_one(Any element)
+    {
+        bool overflow = locked(element, [&](shard &target)
+                               {
+                                   target.tree.insert(element);
+                                   return target.tree.size() > rebalance_limit.load(std::memory_order_relaxed); });
+        if (overflow)
+            reshape(element);
+    }
+
+    void remove_one(Any element)
+    {
+        locked(element, [&](shard &target)
+               { target.tree.remove(element); });
+    }
+
+    bool has(Any &element)
+    {
+        return locked(element, [&](shard &target)
+                      { return target.tree.has(element); });
+    }
+    bool has(Any &&element) { return this->has(element); }
+
+    size_t size(void)
+    {
+        std::lock_guard<std::mutex> guard(reshape_lock); // No element changes shard meanwhile.
+        size_t result = 0;
+        for (size_t i = 0; i < shard_amount; i++)
+            result += shard_size(i);
+        return result;
+    }
+
+    template <typename visitor_t>
+    void scan(const Any &low, const Any &high, visitor_t &&visit)
+    {
+        std::lock_guard<std::mutex> guard(reshape_lock);
+        const layout_t *layout = current.load(std::memory_order_acquire);
+        if (!(low < high))
+            return;
+        for (size_t i = route(layout, low), last = route(layout, high); i <= last; i++)
+        {
+            shard &target = shards[layout->shard_of[i]];
+            std::lock_guard<std::mutex> lock(target.lock);
+            target.tree.scan(low, high, visit);
+        }
+    }
+    // Call `visit(element, count)` for every element in [low, high) in ascending order, across shards.
+
+    void inorder_traversal(Stack &des)
+    {
+        std::lock_guard<std::mutex> guard(reshape_lock);
+        const layout_t *layout = current.load(std::memory_order_acquire);
+        for (size_t i = 0; i < layout->active_amount; i++) // Ranges are ordered, so are their traversals.
+        {
+            shard &target = shards[layout->shard_of[i]];
+            std::lock_guard<std::mutex> lock(target.lock);
+            target.tree.inorder_traversal(des);
+        }
+    }
+
+    std::vector<Any> to_sorted_vector(bool repeated = false)
+    {
+        std::lock_guard<std::mutex> guard(reshape_lock);
+        const layout_t *layout = current.load(std::memory_order_acquire);
+        std::vector<Any> result;
+        for (size_t i = 0; i < layout->active_amount; i++)
+        {
+            shard &target = shards[layout->shard_of[i]];
+            std::lock_guard<std::mutex> lock(target.lock);
+            size_t offset = result.size();
+            result.resize(offset + ((repeated) ? target.tree.size() : target.tree.distinct_size()));
+            target.tree.export_into(result.data() + offset, result.size() - offset, repeated);
+        }
+        return result;
+    }
+
+    void relayout(Layout order = Layout::van_emde_boas)
+    {
+        for (auto &target : shards) // Relayout keeps every element in its shard, so no layout needs holding.
+        {
+            std::lock_guard<std::mutex> lock(target.lock);
+            target.tree.relayout(order);
+        }
+    }
+    // Relayout shard by shard, so only one shard at a time is unavailable; usable from a background thread.
+
+    size_t shards_in_use(void) const
+    {
+        return read_layout([](const layout_t *snapshot)
+                           { return snapshot->active_amount; });
+    }
+
+    size_t rebalances(void) const { return rebalance_amount.load(std::memory_order_relaxed); }
+};
+
+/*
+    Pool the elements of ranges `position` and `position + 1` and cut them in half again, or keep
+    all of them in the first range when merging, which then drops the second range from `next`.
+    Runs of one element are never split. Both shards are locked while moving; returns false,
+    changing nothing, if there is no place to cut.
+*/
+template <typename Any, size_t shard_amount, typename Tree>
+bool ShardedSearchTree<Any, shard_amount, Tree>::regroup(layout_t &next, size_t position, bool merge)
+{
+    shard &lower = shards[next.shard_of[position]], &upper = shards[next.shard_of[position + 1]];
+    std::scoped_lock lock(lower.lock, upper.lock);
+
+    size_t total = lower.tree.size() + upper.tree.size();
+    std::vector<Any> elements(total);
+    size_t used = lower.tree.export_into(elements.data(), total, true);
+    used += upper.tree.export_into(elements.data() + used, total - used, true);
+
+    size_t cut = total;
+    if (!merge)
+    {
+        auto boundary = [&](size_t at)
+        { return at > 0 && at < total && elements[at - 1] < elements[at]; };
+        cut = total / 2;
+        while (cut < total && !boundary(cut))
+            cut++;
+        if (cut == total)
+            for (cut = total / 2; cut > 0 && !boundary(cut); cut--)
+                ;
+        if (cut == 0)
+            return false;
+    }
+
+    lower.tree.clear(), upper.tree.clear();
+    lower.tree.import_from(elements.data(), cut);
+    upper.tree.import_from(elements.data() + cut, total - cut);
+
+    if (merge)
+    {
+        size_t freed = next.shard_of[position + 1];
+        for (size_t i = position + 1; i + 1 < next.active_amount; i++)
+            next.shard_of[i] = next.shard_of[i + 1];
+        for (size_t i = position; i + 1 < next.active_amount; i++)
+            next.bounds[i] = next.bounds[i + 1];
+        next.shard_of[--next.active_amount] = freed; // Unused shards stay listed past the active ones.
+    }
+    else
+        next.bounds[position] = elements[cut];
+    publish(next);
+    return true;
+}
+
+template <typename Any, size_t shard_amount, typename Tree>
+void ShardedSearchTree<Any, shard_amount, Tree>::reshape(const Any &element)
+{
+    std::lock_guard<std::mutex> guard(reshape_lock);
+
+    layout_t next = *current.load(std::memory_order_relaxed); // Only changed under `reshape_lock`.
+    size_t limit = rebalance_limit.load(std::memory_order_relaxed);
+    size_t position = route(&next, element);
+    if (shard_size(next.shard_of[position]) <= limit) // Someone else got here first.
+        return;
+
+    size_t sizes[shard_amount];
+    for (size_t i = 0; i < next.active_amount; i++)
+        sizes[i] = shard_size(next.shard_of[i]);
+
+    if (next.active_amount == shard_amount) // Free a shard by merging the lightest pair of other neighbours.
+    {
+        size_t lightest = shard_amount;
+        for (size_t i = 0; i + 1 < next.active_amount; i++)
+            if (i != position && i + 1 != position &&
+                (lightest == shard_amount || sizes[i] + sizes[i + 1] < sizes[lightest] + sizes[lightest + 1]))
+                lightest = i;
+        if (lightest != shard_amount && sizes[lightest] + sizes[lightest + 1] <= limit / 2 && regroup(next, lightest, true))
+            position -= (lightest < position);
+    }
+
+    if (next.active_amount < shard_amount) // Split into a spare shard placed right after `position`.
+    {
+        size_t spare = next.shard_of[next.active_amount];
+        for (size_t i = next.active_amount; i > position + 1; i--)
+            next.shard_of[i] = next.shard_of[i - 1];
+        for (size_t i = next.active_amount; i > position; i--)
+            next.bounds[i] = next.bounds[i - 1];
+        next.shard_of[position + 1] = spare;
+        next.active_amount++;
+        if (regroup(next, position, false))
+            return;
+        return redistribute(); // One element fills the shard; `next` was never published.
+    }
+
+    size_t neighbour = (position == 0 || (position + 1 < next.active_amount && sizes[position + 1] < sizes[position - 1]))
+                           ? position + 1
+                           : position - 1;
+    if (neighbour < next.active_amount && sizes[neighbour] < limit / 2 &&
+        regroup(next, (neighbour < position) ? neighbour : position, false))
+        return;
+
+    redistribute();
+}
+
+template <typename Any, size_t shard_amount, typename Tree>
+void ShardedSearchTree<Any, shard_amount, Tree>::redistribute(void) // Call with `reshape_lock`.
+{
+    std::unique_lock<std::mutex> locks[shard_amount];
+    for (size_t i = 0; i < shard_amount; i++) // Always in index order, so never against another reshape.
+        locks[i] = std::unique_lock<std::mutex>(shards[i].lock);
+
+    const layout_t *layout = current.load(std::memory_order_relaxed);
+    size_t total = 0;
+    for (auto &target : shards)
+        total += target.tree.size();
+
+    std::vector<Any> elements(total);
+    size_t used = 0;
+    for (size_t i = 0; i < layout->active_amount; i++)
+        used += shards[layout->shard_of[i]].tree.export_into(elements.data() + used, total - used, true);
+
+    /*
+        Cut at the quantiles of the stored elements. Runs of one element are never split,
+        so heavily repeated elements may leave some shards unused.
+    */
+    size_t starts[shard_amount + 1];
+    size_t amount = 0;
+    starts[amount++] = 0;
+    for (size_t i = 1; i < shard_amount; i++)
+    {
+        size_t cut = total * i / shard_amount;
+        while (cut < total && cut > 0 && !(elements[cut - 1] < elements[cut]))
+            cut++;
+        if (cut < total && cut > starts[amount - 1])
+            starts[amount++] = cut;
+    }
+    starts[amount] = total;
+
+    layout_t next = {};
+    next.active_amount = amount;
+    for (size_t i = 0; i < shard_amount; i++)
+    {
+        next.shard_of[i] = i;
+        shards[i].tree.clear();
+        shards[i].pool.release();
+    }
+    size_t largest = 0;
+    for (size_t i = 0; i < amount; i++)
+    {
+        shards[i].tree.import_from(elements.data() + starts[i], starts[i + 1] - starts[i]);
+        if (i > 0)
+            next.bounds[i - 1] = elements[starts[i]];
+        largest = (starts[i + 1] - starts[i] > largest) ? starts[i + 1] - starts[i] : largest;
+    }
+    publish(next);
+
+    /*
+        Leave every shard at about a quarter of the limit, so a skewed stream of insertions can be
+        absorbed by splits and merges until the stored amount has roughly doubled.
+    */
+    size_t limit = (4 * total / shard_amount > 2 * largest) ? 4 * total / shard_amount : 2 * largest;
+    rebalance_limit.store((limit > minimum_limit) ? limit : minimum_limit, std::memory_order_relaxed);
+    rebalance_amount.fetch_add(1, std::memory_order_relaxed);
+}
+
+#endif
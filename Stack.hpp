@@ -10,6 +10,9 @@ private:
     size_t memory_size;
     char *sp; // Point to the byte prepared for usage.
     size_t used_bytes;
+    memory_resource *resource; // Source of `memory`.
+
+    static constexpr size_t alignment = alignof(std::max_align_t);
 
 protected:
     void _push_element(void) {}
@@ -22,39 +25,38 @@ protected:
     }
 
 public:
-    Stack(void)
+    Stack(void) : Stack(256) {}
+
+    Stack(size_t size) : Stack(size, std::pmr::get_default_resource()) {}
+
+    Stack(size_t size, memory_resource *resource)
     {
-        memory_size = 256;
-        memory = malloc(memory_size);
+        this->resource = resource;
+        memory_size = size;
+        memory = resource->allocate(memory_size, alignment);
         sp = static_cast<char *>(memory);
         used_bytes = 0;
     }
 
     Stack(const Stack &other)
     {
+        resource = std::pmr::get_default_resource();
         memory_size = other.memory_size;
         used_bytes = other.used_bytes;
-        memory = malloc(memory_size);
+        memory = resource->allocate(memory_size, alignment);
         memcpy(memory, other.memory, used_bytes);
         sp = static_cast<char *>(memory) + used_bytes;
     }
 
     Stack(Stack &&other)
     {
+        resource = other.resource;
         memory_size = other.memory_size, other.memory_size = 0;
         used_bytes = other.used_bytes, other.used_bytes = 0;
         memory = other.memory, other.memory = nullptr;
         sp = other.sp, other.sp = 0;
     }
 
-    Stack(size_t size)
-    {
-        memory_size = size;
-        memory = malloc(memory_size);
-        sp = static_cast<char *>(memory);
-        used_bytes = 0;
-    }
-
     template <typename... Args>
     Stack &push(Args &&...parameters)
     {
@@ -84,14 +86,23 @@ public:
 
     void allocate_memory(size_t size)
     {
-        memory_size = size;
         void *tmp = memory;
-        memory = malloc(memory_size);
+        memory = resource->allocate(size, alignment);
         memcpy(memory, tmp, used_bytes);
-        free(memory);
+        if (tmp)
+            resource->deallocate(tmp, memory_size, alignment);
+        memory_size = size;
         sp = static_cast<char *>(memory) + used_bytes;
     }
 
+    void clear(void) // Drop every element but keep the memory.
+    {
+        sp = static_cast<char *>(memory);
+        used_bytes = 0;
+    }
+
+    size_t capacity(void) const { return memory_size; }
+
     bool is_full(void) { return used_bytes == memory_size; }
     bool is_empty(void) { return !static_cast<bool>(used_bytes); }
     operator bool(void) { return static_cast<bool>(used_bytes); }
@@ -99,7 +110,7 @@ public:
     ~Stack(void) noexcept
     {
         if (memory)
-            free(memory);
+            resource->deallocate(memory, memory_size, alignment);
     }
 };
 
@@ -0,0 +1,92 @@
+#ifndef _STATICTREE_HEADER
+#define _STATICTREE_HEADER
+
+#include "defs.hpp"
+
+/*
+    Search tree over a set fixed at compile time.
+    Built by a constexpr constructor into a flat table in Eytzinger (breadth-first) order, so a
+    `static constexpr` instance lives in read-only data, costs nothing at startup and allocates
+    nothing, and `has`/`count` fold to constants when the key is known as well.
+*/
+template <typename Any, size_t capacity>
+class StaticSearchTree
+{
+private:
+    Any table[capacity + 1];            // Index 0 is unused; the children of `i` are `2i` and `2i + 1`.
+    unsigned int counts[capacity + 1];  // Same meaning as `unit::element_count`.
+    size_t distinct_amount, element_amount;
+
+    constexpr void place(const Any *sorted, const unsigned int *sorted_counts, size_t &next, size_t index)
+    {
+        if (index <= distinct_amount)
+        {
+            place(sorted, sorted_counts, next, 2 * index);
+            table[index] = sorted[next], counts[index] = sorted_counts[next];
+            next++;
+            place(sorted, sorted_counts, next, 2 * index + 1);
+        }
+    }
+
+    constexpr size_t locate(const Any &element) const // Index of the first element not less than `element`, or 0.
+    {
+        size_t index = 1;
+        while (index <= distinct_amount)
+            index = 2 * index + static_cast<size_t>(table[index] < element); // Branchless descent.
+        while (index & 1)
+            index >>= 1; // Undo the right turns taken below the answer.
+        return index >> 1;
+    }
+
+public:
+    template <typename... Args>
+    constexpr StaticSearchTree(Args &&...elements) : table(), counts(), distinct_amount(0), element_amount(sizeof...(Args))
+    {
+        static_assert((is_same_v<decay_t<Args>, decay_t<Any>> && ...), "StaticSearchTree <- Wrong type.");
+        static_assert(sizeof...(Args) == capacity, "StaticSearchTree <- Capacity does not match.");
+
+        Any sorted[capacity + 1] = {forward<Args>(elements)...};
+        unsigned int sorted_counts[capacity + 1] = {};
+
+        for (size_t i = 1; i < capacity; i++) // Insertion sort, evaluated by the compiler.
+            for (size_t j = i; j > 0 && sorted[j] < sorted[j - 1]; j--)
+            {
+                Any tmp = sorted[j];
+                sorted[j] = sorted[j - 1], sorted[j - 1] = tmp;
+            }
+
+        for (size_t i = 0; i < capacity; i++) // Merge repeated elements.
+        {
+            if (distinct_amount && !(sorted[distinct_amount - 1] < sorted[i]))
+                sorted_counts[distinct_amount - 1]++;
+            else
+                sorted[distinct_amount] = sorted[i], sorted_counts[distinct_amount++] = 1;
+        }
+
+        size_t next = 0;
+        place(sorted, sorted_counts, next, 1);
+    }
+
+    constexpr unsigned int count(const Any &element) const
+    {
+        size_t index = locate(element);
+        return (index && !(element < table[index])) ? counts[index] : 0;
+    }
+
+    constexpr bool has(const Any &element) const { return count(element) != 0; }
+
+    constexpr size_t size(void) const { return element_amount; }
+    constexpr size_t distinct_size(void) const { return distinct_amount; }
+};
+
+template <typename first_t, typename... Args>
+StaticSearchTree(first_t, Args...) -> StaticSearchTree<first_t, 1 + sizeof...(Args)>;
+
+template <typename Any, typename... Args>
+constexpr StaticSearchTree<Any, sizeof...(Args)> make_static_tree(Args &&...elements)
+{
+    return StaticSearchTree<Any, sizeof...(Args)>(forward<Args>(elements)...);
+}
+// E.g. `static constexpr auto codes = make_static_tree<int>(200, 404, 500);`
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef _TRACE_HEADER
+#define _TRACE_HEADER
+
+#include "defs.hpp"
+
+enum class TraceOperation : unsigned char
+{
+    insert,
+    remove,
+    has,
+    preorder_traversal,
+    inorder_traversal,
+    postorder_traversal,
+    append,
+    pop,
+};
+
+inline bool carries_element(TraceOperation operation)
+{
+    return operation == TraceOperation::insert || operation == TraceOperation::remove ||
+           operation == TraceOperation::has || operation == TraceOperation::append;
+}
+
+/*
+    Binary trace format.
+    Header: the bytes "ALVT", one version byte and one byte of element size.
+    Records: one `TraceOperation` byte, followed by the raw bytes of the element if it carries one.
+*/
+class TraceRecorder
+{
+private:
+    static constexpr size_t buffer_size = 1 << 16;
+
+    FILE *file;
+    unsigned char *buffer;
+    size_t used_bytes;
+    size_t element_size; // Zero until the first container is attached.
+
+    void write_header(void)
+    {
+        unsigned char header[6] = {'A', 'L', 'V', 'T', 1, static_cast<unsigned char>(element_size)};
+        memcpy(buffer + used_bytes, header, sizeof(header));
+        used_bytes += sizeof(header);
+    }
+
+public:
+    TraceRecorder(const char *path)
+    {
+        file = fopen(path, "wb");
+        if (file == nullptr)
+            throw "cannot open trace";
+        buffer = static_cast<unsigned char *>(malloc(buffer_size));
+        used_bytes = 0;
+        element_size = 0;
+    }
+
+    TraceRecorder(const TraceRecorder &other) = delete;
+
+    template <typename Any>
+    void bind(void) // Called by containers when the recorder is attached.
+    {
+        static_assert(std::is_trivially_copyable_v<Any>, "TraceRecorder::bind <- Elements must be trivially copyable.");
+        static_assert(sizeof(Any) < 256, "TraceRecorder::bind <- Elements are too large.");
+        if (element_size == 0)
+            element_size = sizeof(Any), write_header();
+        else if (element_size != sizeof(Any))
+            throw "trace element size mismatch";
+    }
+
+    void record(TraceOperation operation)
+    {
+        if (used_bytes + 1 > buffer_size)
+            flush();
+        buffer[used_bytes++] = static_cast<unsigned char>(operation);
+    }
+
+    template <typename Any>
+    void record(TraceOperation operation, const Any &element)
+    {
+        if (used_bytes + 1 + sizeof(Any) > buffer_size)
+            flush();
+        buffer[used_bytes++] = static_cast<unsigned char>(operation);
+        memcpy(buffer + used_bytes, &element, sizeof(Any));
+        used_bytes += sizeof(Any);
+    }
+
+    void flush(void)
+    {
+        fwrite(buffer, 1, used_bytes, file);
+        used_bytes = 0;
+    }
+
+    ~TraceRecorder(void) noexcept
+    {
+        flush();
+        fclose(file);
+        free(buffer);
+    }
+};
+
+class TraceReader // Loads a whole trace so that replaying it does no I/O.
+{
+private:
+    unsigned char *content;
+    size_t content_size;
+    size_t position;
+    size_t element_size;
+
+public:
+    TraceReader(const char *path)
+    {
+        FILE *file = fopen(path, "rb");
+        if (file == nullptr)
+            throw "cannot open trace";
+        fseek(file, 0, SEEK_END);
+        content_size = static_cast<size_t>(ftell(file));
+        fseek(file, 0, SEEK_SET);
+        content = static_cast<unsigned char *>(malloc(content_size ? content_size : 1));
+        content_size = fread(content, 1, content_size, file);
+        fclose(file);
+
+        if (content_size < 6 || memcmp(content, "ALVT", 4) != 0 || content[4] != 1)
+        {
+            free(content);
+            throw "not a trace";
+        }
+        element_size = content[5];
+        position = 6;
+    }
+
+    TraceReader(const TraceReader &other) = delete;
+
+    size_t get_element_size(void) const { return element_size; }
+
+    bool next(TraceOperation &operation, void *element) // Return false at the end of the trace.
+    {
+        if (position >= content_size)
+            return false;
+        operation = static_cast<TraceOperation>(content[position++]);
+        if (carries_element(operation))
+        {
+            if (position + element_size > content_size)
+                throw "truncated trace";
+            memcpy(element, content + position, element_size);
+            position += element_size;
+        }
+        return true;
+    }
+
+    void rewind(void) { position = 6; }
+
+    ~TraceReader(void) noexcept { free(content); }
+};
+
+#endif
@@ -0,0 +1,188 @@
+#include "BinaryTree.hpp"
+#include <algorithm>
+#include <random>
+
+/*
+    Check the shape invariants of every balancing policy and the `rotations()` counts.
+    Prints every failed check and exits with 1 if there was any, e.g.
+        g++ -std=c++17 balance_check.cpp -o balance_check && ./balance_check
+*/
+
+static size_t failures = 0;
+
+static void check(bool condition, const char *policy, const char *what)
+{
+    if (!condition)
+    {
+        print(policy, ": ", what, '\n');
+        failures++;
+    }
+}
+
+template <typename Balance>
+class Inspected : public SearchTree<int, 0, Counted<Balance>> // Counted, so `rotations()` reports.
+{
+private:
+    typedef typename BinaryTree<int>::unit unit;
+
+    static int measure(unit *root) // Real height, -1 for null.
+    {
+        if (root == nullptr)
+            return -1;
+        int left = measure(root->left), right = measure(root->right);
+        return ((left > right) ? left : right) + 1;
+    }
+
+    static int rank(unit *root) { return (root) ? root->height : -1; }
+
+    static bool ordered(unit *root, const int *low, const int *high)
+    {
+        if (root == nullptr)
+            return true;
+        if ((low && !(*low < root->element)) || (high && !(root->element < *high)))
+            return false;
+        return ordered(root->left, low, &root->element) && ordered(root->right, &root->element, high);
+    }
+
+    static bool avl(unit *root)
+    {
+        if (root == nullptr)
+            return true;
+        int difference = measure(root->left) - measure(root->right);
+        return root->height == measure(root) && difference >= -1 && difference <= 1 && avl(root->left) && avl(root->right);
+    }
+
+    static bool wavl(unit *root) // Rank differences of 1 or 2, and leaves have rank 0.
+    {
+        if (root == nullptr)
+            return true;
+        int left = rank(root) - rank(root->left), right = rank(root) - rank(root->right);
+        bool leaf = root->left == nullptr && root->right == nullptr;
+        return left >= 1 && left <= 2 && right >= 1 && right <= 2 && (!leaf || root->height == 0) &&
+               wavl(root->left) && wavl(root->right);
+    }
+
+    static int black_height(unit *root) // -1 if a red unit has a red child or black heights differ.
+    {
+        if (root == nullptr)
+            return 0;
+        bool red = RedBlack::is_red(root);
+        if (red && (RedBlack::is_red(root->left) || RedBlack::is_red(root->right)))
+            return -1;
+        int left = black_height(root->left), right = black_height(root->right);
+        if (left < 0 || left != right)
+            return -1;
+        return left + !red;
+    }
+
+    static bool heap(unit *root)
+    {
+        if (root == nullptr)
+            return true;
+        for (unit *child : {root->left, root->right})
+            if (child && Treap::priority(child) > Treap::priority(root))
+                return false;
+        return heap(root->left) && heap(root->right);
+    }
+
+public:
+    using SearchTree<int, 0, Counted<Balance>>::SearchTree;
+
+    void verify(const char *policy)
+    {
+        unit *root = this->root;
+        check(ordered(root, nullptr, nullptr), policy, "search order broken");
+        if constexpr (is_same_v<Balance, AVL>)
+            check(avl(root), policy, "AVL height or balance broken");
+        if constexpr (is_same_v<Balance, WAVL>)
+            check(wavl(root), policy, "WAVL rank rule broken");
+        if constexpr (is_same_v<Balance, RedBlack>)
+            check(!RedBlack::is_red(root) && black_height(root) >= 0, policy, "red-black rule broken");
+        if constexpr (is_same_v<Balance, Treap>)
+            check(heap(root), policy, "treap heap order broken");
+    }
+};
+
+template <typename Balance>
+void run(const char *policy)
+{
+    {
+        Inspected<Balance> tree;
+        tree.insert(1, 2, 3); // One single rotation for every policy but the treap.
+        tree.verify(policy);
+        if constexpr (!is_same_v<Balance, Treap>)
+            check(tree.rotations() == 1, policy, "ascending triple should rotate once");
+    }
+    {
+        Inspected<Balance> tree;
+        tree.insert(1, 3, 2); // One double rotation, counted as two.
+        tree.verify(policy);
+        if constexpr (!is_same_v<Balance, Treap>)
+            check(tree.rotations() == 2, policy, "zigzag triple should rotate twice");
+    }
+
+    if constexpr (is_same_v<Balance, Treap>)
+    {
+        std::vector<int> elements(1000);
+        for (int i = 0; i < 1000; i++)
+            elements[i] = i;
+        std::sort(elements.begin(), elements.end(), [](int a, int b)
+                  { return mix_bits(std::hash<int>()(a)) > mix_bits(std::hash<int>()(b)); });
+        Inspected<Balance> tree;
+        for (int element : elements) // Highest priority first, so every unit stays where it lands.
+            tree.insert(element);
+        tree.verify(policy);
+        check(tree.rotations() == 0, policy, "insertion by falling priority rotated");
+    }
+
+    Inspected<Balance> tree;
+    std::mt19937 random(7);
+    for (int i = 0; i < 20000; i++)
+        tree.insert(static_cast<int>(random() % 5000));
+    tree.verify(policy);
+
+    size_t rotations = tree.rotations();
+    for (int i = 0; i < 5000; i++)
+        tree.has(i), tree.remove(i);
+    check(tree.rotations() == rotations, policy, "has or remove rotated");
+
+    for (int i = 0; i < 20000; i++)
+        tree.insert(i);
+    tree.verify(policy);
+
+    rotations = tree.rotations();
+    tree.relayout();
+    tree.verify(policy);
+    check(tree.rotations() == rotations, policy, "relayout rotated");
+
+    std::vector<int> sorted(1000);
+    for (int i = 0; i < 1000; i++)
+        sorted[i] = 2 * i;
+    Inspected<Balance> built;
+    built.import_from(sorted.data(), sorted.size()); // Built directly, without rotations.
+    built.verify(policy);
+    check(built.rotations() == 0, policy, "sorted import rotated");
+    for (int i = 0; i < 1000; i++)
+        built.insert(2 * i + 1);
+    built.verify(policy);
+}
+
+int main(int argc, char *argv[])
+{
+    run<AVL>("avl");
+    run<WAVL>("wavl");
+    run<RedBlack>("rb");
+    run<Treap>("treap");
+
+    Inspected<AVL> avl;
+    Inspected<WAVL> wavl;
+    for (int i = 0; i < 4096; i++)
+    {
+        int element = static_cast<int>(mix_bits(static_cast<uint64_t>(i)) % 100000);
+        avl.insert(element), wavl.insert(element);
+    }
+    check(avl.rotations() == wavl.rotations(), "wavl", "insertions should rotate like AVL");
+
+    print((failures) ? "FAILED\n" : "ok\n");
+    return (failures) ? 1 : 0;
+}
@@ -0,0 +1,180 @@
+#include "BinaryTree.hpp"
+
+/*
+    Check that the front cache of `SearchTree` stays correct across every change a unit can go
+    through: removal to a zero count and revival, `relayout`, `clear`, `import_from` and demotion
+    to inline mode. Both the answers of `has` and the hit/miss counters are compared with what the
+    cache should have done. Prints every failed check and exits with 1 if there was any, e.g.
+        g++ -std=c++17 cache_check.cpp -o cache_check && ./cache_check
+*/
+
+static size_t failures = 0;
+
+template <typename Tree>
+class Expect // Follows the counters of `tree` and checks each `has` against the expected outcome.
+{
+private:
+    Tree &tree;
+    const char *stage;
+    size_t hits, misses;
+
+public:
+    Expect(Tree &tree, const char *stage) : tree(tree), stage(stage) { skip(); }
+
+    void skip(void) { hits = tree.cache_hits(), misses = tree.cache_misses(); } // Accept what happened since the last check.
+
+    void has(int element, bool expected, size_t new_hits, size_t new_misses)
+    {
+        bool result = tree.has(element);
+        hits += new_hits, misses += new_misses;
+        if (result != expected || tree.cache_hits() != hits || tree.cache_misses() != misses)
+        {
+            print(stage, ": has(", element, ") gave ", static_cast<int>(result), " with ", tree.cache_hits(), " hits and ",
+                  tree.cache_misses(), " misses, expected ", static_cast<int>(expected), " with ", hits, " and ", misses, '\n');
+            failures++;
+        }
+    }
+
+    void remove(int element, size_t new_hits, size_t new_misses) // A removal looks the element up through the cache too.
+    {
+        tree.remove(element);
+        hits += new_hits, misses += new_misses;
+        if (tree.cache_hits() != hits || tree.cache_misses() != misses)
+        {
+            print(stage, ": remove(", element, ") left ", tree.cache_hits(), " hits and ", tree.cache_misses(), " misses, expected ",
+                  hits, " and ", misses, '\n');
+            failures++;
+        }
+    }
+};
+
+template <size_t slots>
+void tombstones(void) // has -> remove to zero -> has -> reinsert -> has.
+{
+    SearchTree<int, 0, AVL, slots> tree;
+    for (int i = 0; i < 100; i++)
+        tree.insert(i);
+    tree.insert(42);
+
+    Expect<decltype(tree)> expect(tree, "tombstones");
+    expect.has(42, true, 0, 1); // Filled on the miss.
+    expect.has(42, true, 1, 0);
+    expect.remove(42, 1, 0);    // Count 2 -> 1.
+    expect.has(42, true, 1, 0);
+    expect.remove(42, 1, 0);    // Count 1 -> 0: the entry stays, pointing at a removed unit.
+    expect.has(42, false, 1, 0);
+    expect.remove(42, 1, 0);    // Nothing left to remove.
+    tree.insert(42);            // Revives the same unit.
+    expect.has(42, true, 1, 0);
+    expect.has(1000, false, 0, 1); // Absent elements are never filled.
+    expect.has(1000, false, 0, 1);
+}
+
+template <size_t slots>
+void relayout(void)
+{
+    SearchTree<int, 0, AVL, slots> tree;
+    for (int i = 0; i < 1000; i++)
+        tree.insert(i);
+
+    Expect<decltype(tree)> expect(tree, "relayout");
+    expect.has(7, true, 0, 1);
+    expect.has(8, true, 0, 1);
+    expect.remove(8, 1, 0);
+    tree.relayout(); // Every unit moves and the removed one is dropped: the cache must forget all of them.
+    expect.has(7, true, 0, 1);
+    expect.has(7, true, 1, 0);
+    expect.has(8, false, 0, 1);
+    tree.insert(8);
+    expect.has(8, true, 0, 1);
+    expect.has(8, true, 1, 0);
+    tree.relayout(Layout::preorder);
+    expect.has(8, true, 0, 1);
+    expect.has(999, true, 0, 1);
+}
+
+template <size_t slots>
+void clearing(void)
+{
+    SearchTree<int, 0, AVL, slots> tree;
+    for (int i = 0; i < 100; i++)
+        tree.insert(i);
+
+    Expect<decltype(tree)> expect(tree, "clear");
+    expect.has(5, true, 0, 1);
+    tree.clear();
+    expect.has(5, false, 0, 1);
+    tree.insert(5, 6);
+    expect.has(5, true, 0, 1);
+    expect.has(5, true, 1, 0);
+}
+
+template <size_t slots>
+void import(void)
+{
+    SearchTree<int, 0, AVL, slots> tree;
+    for (int i = 0; i < 50; i++)
+        tree.insert(i);
+
+    Expect<decltype(tree)> expect(tree, "import_from");
+    expect.has(10, true, 0, 1);
+    expect.has(11, true, 0, 1);
+    for (int i = 0; i < 50; i++)
+        tree.remove(i); // Leaves only removed units, so the import below rebuilds the tree.
+    expect.skip();
+
+    int sorted[] = {11, 12, 13, 20};
+    tree.import_from(sorted, 4);
+    expect.has(10, false, 0, 1);
+    expect.has(11, true, 0, 1);
+    expect.has(11, true, 1, 0);
+
+    int unsorted[] = {30, 10}; // Inserted one by one into the live tree.
+    tree.import_from(unsorted, 2);
+    expect.has(10, true, 0, 1);
+    expect.has(11, true, 1, 0);
+}
+
+template <size_t slots>
+void demotion(void)
+{
+    SearchTree<int, 8, AVL, slots> tree;
+    for (int i = 0; i < 20; i++)
+        tree.insert(i);
+
+    Expect<decltype(tree)> expect(tree, "demotion");
+    expect.has(3, true, 0, 1);
+    expect.has(15, true, 0, 1);
+    for (int i = 4; i < 20; i++)
+        tree.remove(i); // Down to 4 distinct elements: back to inline mode, units released.
+    expect.skip();
+    expect.has(3, true, 0, 0); // Answered inline, without the cache.
+    expect.has(15, false, 0, 0);
+
+    for (int i = 10; i < 30; i++)
+        tree.insert(i); // Promoted again, into new units.
+    expect.has(15, true, 0, 1);
+    expect.has(15, true, 1, 0);
+    expect.has(3, true, 0, 1);
+    expect.has(5, false, 0, 1);
+}
+
+template <size_t slots>
+void run(void)
+{
+    tombstones<slots>();
+    relayout<slots>();
+    clearing<slots>();
+    import<slots>();
+    demotion<slots>();
+}
+
+int main(int argc, char *argv[])
+{
+    run<2>(); // A single set, so every element competes for the same two ways.
+    run<64>();
+    run<1024>();
+
+    print((failures) ? "FAILED\n" : "ok\n");
+    return (failures) ? 1 : 0;
+}
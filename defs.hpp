@@ -7,10 +7,37 @@
 #include <utility>
 #include <type_traits>
 #include <memory>
+#include <memory_resource>
+#include <string.h>
+#include <stdint.h>
 
 using std::initializer_list;
 using std::is_same_v, std::decay_t;
 using std::move, std::forward;
+using std::pmr::memory_resource;
+
+inline uint64_t mix_bits(uint64_t x) // Finalizer of splitmix64, spreads hashes over all bits.
+{
+    x ^= x >> 30, x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27, x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+/*
+    Containers take an optional `memory_resource *` as the first constructor argument, e.g.
+    `SearchTree<int> tree(&pool, 1, 2)`, and make every internal allocation from it. Copies use the
+    default resource, as in std::pmr. With a monotonic resource, whose memory is reclaimed as a
+    whole, `skip_release()` lets the destructor leave the units alone.
+    Return the resource if present, or the default resource otherwise.
+*/
+template <typename first_t>
+inline memory_resource *select_resource(first_t &&first)
+{
+    if constexpr (std::is_convertible_v<first_t, memory_resource *>)
+        return first;
+    else
+        return std::pmr::get_default_resource();
+}
 
 inline void print(const char *str) { printf("%s", str); }
 inline void print(char *str) { printf("%s", str); }
@@ -0,0 +1,237 @@
+#include "BinaryTree.hpp"
+#include <chrono>
+
+/*
+    Replay a trace written by `TraceRecorder` against a chosen container configuration,
+    then report throughput and latency percentiles per operation.
+
+    Usage: replay <trace> [tree] [resource]
+        tree:     avl | wavl | rb | treap | inline | cached | all    (default: avl)
+        resource: new | pool | monotonic                             (default: new)
+    `inline` is AVL with a 32-element inline mode, `cached` is AVL behind a 256-slot front cache;
+    `all` replays the trace once per balancing policy, each on a freshly constructed resource.
+    Elements of 4 bytes are replayed as `int`, elements of 8 bytes as `long long`.
+*/
+
+class LatencyHistogram // Log-linear buckets: exact below 32ns, then 16 buckets per power of two.
+{
+private:
+    static constexpr size_t bucket_amount = 1024;
+
+    size_t counts[bucket_amount];
+    size_t total;
+    unsigned long long maximum;
+
+    static size_t locate(unsigned long long ns)
+    {
+        if (ns < 32)
+            return static_cast<size_t>(ns);
+        int msb = 63 - __builtin_clzll(ns);
+        return 32 + static_cast<size_t>(msb - 5) * 16 + static_cast<size_t>((ns >> (msb - 4)) & 15);
+    }
+
+    static unsigned long long upper_bound(size_t index) // Largest latency falling into the bucket.
+    {
+        if (index < 32)
+            return index;
+        int msb = static_cast<int>((index - 32) / 16) + 5;
+        unsigned long long sub = (index - 32) % 16;
+        return ((17 + sub) << (msb - 4)) - 1;
+    }
+
+public:
+    LatencyHistogram(void)
+    {
+        memset(counts, 0, sizeof(counts));
+        total = 0, maximum = 0;
+    }
+
+    void add(unsigned long long ns)
+    {
+        counts[locate(ns)]++, total++;
+        if (ns > maximum)
+            maximum = ns;
+    }
+
+    size_t amount(void) const { return total; }
+    unsigned long long max(void) const { return maximum; }
+
+    unsigned long long percentile(double fraction) const
+    {
+        size_t target = static_cast<size_t>(fraction * total);
+        if (target >= total)
+            target = total - 1;
+
+        size_t seen = 0;
+        for (size_t i = 0; i < bucket_amount; i++)
+        {
+            seen += counts[i];
+            if (seen > target)
+                return upper_bound(i) < maximum ? upper_bound(i) : maximum;
+        }
+        return maximum;
+    }
+};
+
+static const char *operation_names[] = {
+    "insert", "remove", "has", "preorder", "inorder", "postorder", "append", "pop"};
+
+static bool known_resource(const char *source)
+{
+    return strcmp(source, "new") == 0 || strcmp(source, "pool") == 0 || strcmp(source, "monotonic") == 0;
+}
+
+template <typename Any, typename Tree>
+void replay(TraceReader &reader, const char *source)
+{
+    typedef std::chrono::steady_clock clock;
+
+    std::pmr::unsynchronized_pool_resource pool; // Fresh for every replay, so runs do not share state.
+    std::pmr::monotonic_buffer_resource monotonic;
+    memory_resource *resource = std::pmr::new_delete_resource();
+    if (strcmp(source, "pool") == 0)
+        resource = &pool;
+    else if (strcmp(source, "monotonic") == 0)
+        resource = &monotonic;
+
+    Tree tree(resource);
+    Queue<Any> queue(resource);
+    Stack stack(sizeof(Any), std::pmr::new_delete_resource()); // Traversal scratch, kept off the measured resource.
+    LatencyHistogram histograms[8];
+    size_t hits = 0;
+
+    TraceOperation operation;
+    Any element;
+    clock::duration elapsed = clock::duration::zero();
+    while (reader.next(operation, &element))
+    {
+        stack.clear();
+        if (stack.capacity() < (tree.size() + 1) * sizeof(Any)) // Grown outside the measurement.
+            stack.allocate_memory(2 * (tree.size() + 1) * sizeof(Any));
+
+        auto start = clock::now();
+        switch (operation)
+        {
+        case TraceOperation::insert:
+            tree.insert(element);
+            break;
+        case TraceOperation::remove:
+            tree.remove(element);
+            break;
+        case TraceOperation::has:
+            hits += tree.has(element);
+            break;
+        case TraceOperation::preorder_traversal:
+            tree.preorder_traversal(stack);
+            break;
+        case TraceOperation::inorder_traversal:
+            tree.inorder_traversal(stack);
+            break;
+        case TraceOperation::postorder_traversal:
+            tree.postorder_traversal(stack);
+            break;
+        case TraceOperation::append:
+            queue.append(element);
+            break;
+        case TraceOperation::pop:
+            queue >> element;
+            break;
+        default:
+            throw "unknown operation";
+        }
+        auto stop = clock::now();
+
+        elapsed += stop - start;
+        histograms[static_cast<size_t>(operation)].add(
+            static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()));
+    }
+
+    size_t operations = 0;
+    for (auto &histogram : histograms)
+        operations += histogram.amount();
+    double seconds = std::chrono::duration<double>(elapsed).count();
+
+    printf("operations: %zu  time: %.6fs  throughput: %.0f ops/s  hits: %zu  rotations: %zu\n",
+           operations, seconds, seconds > 0 ? operations / seconds : 0.0, hits, tree.rotations());
+    if (tree.cache_hits() + tree.cache_misses())
+        printf("cache hits: %zu  cache misses: %zu\n", tree.cache_hits(), tree.cache_misses());
+    printf("%-10s %12s %10s %10s %10s %10s\n", "operation", "count", "p50(ns)", "p99(ns)", "p999(ns)", "max(ns)");
+    for (size_t i = 0; i < 8; i++)
+        if (histograms[i].amount())
+            printf("%-10s %12zu %10llu %10llu %10llu %10llu\n", operation_names[i], histograms[i].amount(),
+                   histograms[i].percentile(0.5), histograms[i].percentile(0.99),
+                   histograms[i].percentile(0.999), histograms[i].max());
+}
+
+template <typename Any>
+bool dispatch(const char *tree, TraceReader &reader, const char *source)
+{
+    if (strcmp(tree, "avl") == 0 || strcmp(tree, "plain") == 0)
+        replay<Any, SearchTree<Any, 0, Counted<AVL>>>(reader, source);
+    else if (strcmp(tree, "wavl") == 0)
+        replay<Any, SearchTree<Any, 0, Counted<WAVL>>>(reader, source);
+    else if (strcmp(tree, "rb") == 0)
+        replay<Any, SearchTree<Any, 0, Counted<RedBlack>>>(reader, source);
+    else if (strcmp(tree, "treap") == 0)
+        replay<Any, SearchTree<Any, 0, Counted<Treap>>>(reader, source);
+    else if (strcmp(tree, "inline") == 0)
+        replay<Any, SearchTree<Any, 32, Counted<AVL>>>(reader, source);
+    else if (strcmp(tree, "cached") == 0)
+        replay<Any, SearchTree<Any, 0, Counted<AVL>, 256>>(reader, source);
+    else if (strcmp(tree, "all") == 0)
+    {
+        for (const char *policy : {"avl", "wavl", "rb", "treap"})
+        {
+            print("== ", policy, " ==\n");
+            reader.rewind();
+            dispatch<Any>(policy, reader, source);
+        }
+    }
+    else
+        return false;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        print("usage: replay <trace> [avl|wavl|rb|treap|inline|cached|all] [new|pool|monotonic]\n");
+        return 1;
+    }
+    const char *tree = (argc > 2) ? argv[2] : "avl";
+    const char *source = (argc > 3) ? argv[3] : "new";
+
+    try
+    {
+        TraceReader reader(argv[1]);
+
+        if (!known_resource(source))
+        {
+            print("unknown resource: ", source, '\n');
+            return 1;
+        }
+
+        bool known;
+        if (reader.get_element_size() == sizeof(int))
+            known = dispatch<int>(tree, reader, source);
+        else if (reader.get_element_size() == sizeof(long long))
+            known = dispatch<long long>(tree, reader, source);
+        else
+        {
+            print("unsupported element size: ", reader.get_element_size(), '\n');
+            return 1;
+        }
+
+        if (!known)
+        {
+            print("unknown tree: ", tree, '\n');
+            return 1;
+        }
+    }
+    catch (const char *message)
+    {
+        print("error: ", message, '\n');
+        return 1;
+    }
+}
@@ -0,0 +1,173 @@
+#include "ShardedTree.hpp"
+#include <chrono>
+#include <random>
+#include <thread>
+
+/*
+    Multi-threaded benchmark for `ShardedSearchTree`, against one `SearchTree` behind a mutex.
+    Every thread mixes insertions (50%), lookups (40%) and removals of its own earlier insertions
+    (10%) over its own keys, so the final contents are known and checked after every run.
+
+    Usage: sharded_bench [threads] [operations] [random | sequential | window]    (default: cores, 2000000, random)
+    Thread counts double from 1 up to `threads`; `sequential` has each thread insert ascending keys,
+    the worst case for range sharding. `window` slides over ascending keys instead: every operation
+    inserts key `i` and removes key `i - 50000`, so the size stays flat while the ranges keep moving
+    and layouts keep being replaced. The same program is the concurrency stress test:
+        g++ -std=c++17 -O2 -pthread sharded_bench.cpp -o sharded_bench
+        g++ -std=c++17 -O1 -g -fsanitize=thread -pthread sharded_bench.cpp -o sharded_bench_tsan && ./sharded_bench_tsan 4 200000
+*/
+
+typedef long long element_t;
+
+class LockedTree // The baseline: one tree, one lock.
+{
+private:
+    std::mutex lock;
+    SearchTree<element_t> tree;
+
+public:
+    void insert(element_t element)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        tree.insert(element);
+    }
+
+    void remove(element_t element)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        tree.remove(element);
+    }
+
+    bool has(element_t element)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return tree.has(element);
+    }
+
+    std::vector<element_t> to_sorted_vector(bool repeated) { return tree.to_sorted_vector(repeated); }
+};
+
+enum class Pattern
+{
+    random,
+    sequential,
+    window
+};
+
+struct Workload
+{
+    static constexpr size_t window = 50000; // Elements kept by the `window` pattern, across all threads.
+
+    size_t threads, operations;
+    Pattern pattern;
+
+    element_t key(size_t thread, size_t step, std::mt19937_64 &random) const // Keys of different threads never meet.
+    {
+        if (pattern != Pattern::random)
+            return static_cast<element_t>((thread * operations + step) * threads + thread);
+        return static_cast<element_t>((random() % (operations * 4)) * threads + thread);
+    }
+
+    template <typename tree_t>
+    void run(tree_t &tree, size_t thread, SearchTree<element_t> *expected) const // Record the final contents into `expected` if given.
+    {
+        std::mt19937_64 random(thread + 1);
+        if (pattern == Pattern::window) // No lookups, so `tree` is `expected` when recording.
+        {
+            for (size_t i = 0, width = window / threads; i < operations / threads; i++)
+            {
+                tree.insert(key(thread, i, random));
+                if (i >= width)
+                    tree.remove(key(thread, i - width, random));
+            }
+            return;
+        }
+
+        std::vector<element_t> inserted;
+        inserted.reserve(operations / threads);
+        for (size_t i = 0; i < operations / threads; i++)
+        {
+            size_t choice = random() % 10;
+            if (choice < 5 || inserted.empty())
+            {
+                inserted.push_back(key(thread, i, random));
+                if (expected)
+                    expected->insert(inserted.back());
+                else
+                    tree.insert(inserted.back());
+            }
+            else if (choice < 9)
+            {
+                element_t element = key(thread, i, random); // Drawn either way to keep both runs in step.
+                if (!expected)
+                    tree.has(element);
+            }
+            else
+            {
+                element_t element = inserted[random() % inserted.size()];
+                if (expected)
+                    expected->remove(element);
+                else
+                    tree.remove(element);
+            }
+        }
+    }
+
+    template <typename tree_t>
+    double measure(tree_t &tree) const // Seconds for all threads to finish.
+    {
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < threads; i++)
+            workers.emplace_back([this, &tree, i]
+                                 { run(tree, i, nullptr); });
+        for (auto &worker : workers)
+            worker.join();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::vector<element_t> expect(void) const
+    {
+        SearchTree<element_t> expected;
+        for (size_t i = 0; i < threads; i++)
+            run(expected, i, &expected);
+        return expected.to_sorted_vector(true);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    size_t most = (argc > 1) ? strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    size_t operations = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 2000000;
+    Pattern pattern = Pattern::random;
+    if (argc > 3 && strcmp(argv[3], "sequential") == 0)
+        pattern = Pattern::sequential;
+    if (argc > 3 && strcmp(argv[3], "window") == 0)
+        pattern = Pattern::window;
+    most = (most) ? most : 1;
+
+    printf("%8s %14s %10s %14s %10s %10s\n", "threads", "sharded ops/s", "speedup", "locked ops/s", "speedup", "rebuilds");
+    double sharded_single = 0, locked_single = 0;
+    bool correct = true;
+    for (size_t threads = 1; threads <= most; threads *= 2)
+    {
+        Workload workload = {threads, operations, pattern};
+        std::vector<element_t> expected = workload.expect();
+
+        ShardedSearchTree<element_t> sharded;
+        double sharded_rate = operations / workload.measure(sharded);
+        correct = correct && sharded.to_sorted_vector(true) == expected;
+
+        LockedTree locked;
+        double locked_rate = operations / workload.measure(locked);
+        correct = correct && locked.to_sorted_vector(true) == expected;
+
+        sharded_single = (threads == 1) ? sharded_rate : sharded_single;
+        locked_single = (threads == 1) ? locked_rate : locked_single;
+        printf("%8zu %14.0f %10.2f %14.0f %10.2f %10zu\n", threads, sharded_rate, sharded_rate / sharded_single,
+               locked_rate, locked_rate / locked_single, sharded.rebalances());
+    }
+
+    print((correct) ? "contents ok\n" : "contents MISMATCH\n");
+    return (correct) ? 0 : 1;
+}
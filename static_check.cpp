@@ -0,0 +1,52 @@
+#include "StaticTree.hpp"
+
+/*
+    Compile-time checks of `StaticSearchTree`: every assertion below is evaluated by the compiler,
+    so the file only builds if the lookups are right, e.g.
+        g++ -std=c++17 static_check.cpp -o static_check && ./static_check
+*/
+
+template <typename Tree, size_t amount>
+constexpr bool agrees(const Tree &tree, const int (&elements)[amount], int low, int high) // `count` against a linear scan.
+{
+    for (int key = low; key <= high; key++)
+    {
+        unsigned int expected = 0;
+        for (size_t i = 0; i < amount; i++)
+            expected += elements[i] == key;
+        if (tree.count(key) != expected || tree.has(key) != (expected != 0))
+            return false;
+    }
+    return true;
+}
+
+static constexpr auto codes = make_static_tree<int>(500, 200, 404, 200, 301, 200);
+static_assert(codes.size() == 6 && codes.distinct_size() == 4);
+static_assert(codes.has(200) && codes.has(301) && codes.has(404) && codes.has(500));
+static_assert(codes.count(200) == 3 && codes.count(301) == 1); // Repeated elements.
+static_assert(!codes.has(199) && !codes.has(-1));               // Below the smallest.
+static_assert(!codes.has(501) && codes.count(100000) == 0);     // Above the largest.
+static_assert(!codes.has(201) && !codes.has(403) && !codes.has(405)); // Between stored elements.
+
+static constexpr StaticSearchTree single(7); // Deduced as `StaticSearchTree<int, 1>`.
+static_assert(single.has(7) && !single.has(6) && !single.has(8) && single.count(7) == 1);
+
+static constexpr StaticSearchTree<int, 0> empty;
+static_assert(empty.size() == 0 && empty.distinct_size() == 0);
+static_assert(!empty.has(0) && empty.count(1) == 0);
+static_assert(make_static_tree<int>().distinct_size() == 0);
+
+static constexpr int odd[] = {29, 1, 3, 27, 5, 25, 7, 23, 9, 21, 11, 19, 13, 17, 15, 3, 15, 15}; // Neither full nor a power of 2.
+static constexpr auto odds = make_static_tree<int>(29, 1, 3, 27, 5, 25, 7, 23, 9, 21, 11, 19, 13, 17, 15, 3, 15, 15);
+static_assert(odds.size() == 18 && odds.distinct_size() == 15);
+static_assert(agrees(odds, odd, -2, 32));
+
+static constexpr int full[] = {6, 2, 4, 1, 7, 3, 5}; // A complete tree of 7.
+static constexpr auto fulls = make_static_tree<int>(6, 2, 4, 1, 7, 3, 5);
+static_assert(agrees(fulls, full, -1, 9));
+
+int main(int argc, char *argv[])
+{
+    print("ok\n");
+    return 0;
+}